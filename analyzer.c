@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_analysis.h"
+#include "minesweeper_board.h"
+#include "minesweeper_random.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Totals over every analysed board.
+ *
+ */
+typedef struct {
+  atomic_uint_fast64_t boards;  /*! Boards analysed */
+  atomic_uint_fast64_t invalid; /*! Lines which weren't valid boards */
+  atomic_uint_fast64_t bbbv;    /*! Sum of the 3BV of every board */
+  bool quiet;                   /*! Only print the totals */
+} ANALYZER_TOTALS;
+
+/**
+ * @brief Prints how to use the analyzer.
+ *
+ * @param name  [in]    The name the program was run as.
+ */
+static void usage(const char *name) {
+  printf("Usage: %s [-j threads] [-q] file...\n"
+         "       %s -g count [-p preset] [-S seed]\n"
+         "\n"
+         "  -j  number of threads (default one per core)\n"
+         "  -q  only print the totals, not every board\n"
+         "  -g  write count random boards to stdout as a board file\n"
+         "  -p  beginner (default), intermediate or expert\n"
+         "  -S  seed (default 1)\n",
+         name, name);
+}
+
+/**
+ * @brief Prints a board's analysis as a CSV line and adds it to the totals.
+ */
+static void print_analysis(const char *path, uint64_t line,
+                           MINESWEEPER_RESULT result,
+                           const MINESWEEPER_ANALYSIS *analysis,
+                           void *context) {
+  ANALYZER_TOTALS *totals = context;
+
+  if (MINESWEEPER_RESULT_SUCCESS != result) {
+    atomic_fetch_add(&totals->invalid, 1u);
+    fprintf(stderr, "%s:%llu: invalid board (error code %u)\n", path,
+            (unsigned long long)line, result);
+    return;
+  }
+  atomic_fetch_add(&totals->boards, 1u);
+  atomic_fetch_add(&totals->bbbv, analysis->bbbv);
+  if (!totals->quiet) {
+    /* A single call, so lines from different threads don't interleave */
+    printf("%s,%llu,%u,%u,%u,%.4f\n", path, (unsigned long long)line,
+           analysis->bbbv, analysis->openings, analysis->isolated,
+           analysis->density);
+  }
+}
+
+/**
+ * @brief Writes random boards to stdout.
+ *
+ * @param preset    [in]    The preset for the boards.
+ * @param count     [in]    Number of boards to write.
+ * @param seed      [in]    The seed.
+ * @return int The exit code.
+ */
+static int generate(MINESWEEPER_PRESET preset, uint64_t count,
+                    uint64_t seed) {
+  MINESWEEPER_POINT mines[MINESWEEPER_PRESET_MAX_MINES];
+  MINESWEEPER_STATE grid[MINESWEEPER_PRESET_MAX_SIZE];
+  MINESWEEPER_BOARD board;
+  MINESWEEPER_RANDOM rng;
+
+  if (MINESWEEPER_RESULT_SUCCESS !=
+      minesweeper_board_init_preset(&board, grid, preset)) {
+    return EXIT_FAILURE;
+  }
+  minesweeper_random_seed(&rng, seed, 0);
+  for (uint64_t i = 0; i < count; i++) {
+    minesweeper_random_mines(&rng, board.width, board.height, board.mine_count,
+                             mines);
+    if (MINESWEEPER_RESULT_SUCCESS !=
+        minesweeper_analysis_write_board(stdout, board.width, board.height,
+                                         board.mine_count, mines)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+  MINESWEEPER_PRESET preset = MINESWEEPER_PRESET_BEGINNER;
+  ANALYZER_TOTALS totals;
+  uint64_t generate_count = 0;
+  uint64_t seed = 1u;
+  uint32_t threads = 0;
+  bool quiet = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "j:qg:p:S:")) != -1) {
+    switch (opt) {
+    case 'j':
+      threads = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'q':
+      quiet = true;
+      break;
+    case 'g':
+      generate_count = strtoull(optarg, NULL, 0);
+      break;
+    case 'p':
+      preset = minesweeper_preset_from_name(optarg);
+      if (MINESWEEPER_PRESET_CUSTOM == preset) {
+        printf("Unknown preset '%s'\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'S':
+      seed = strtoull(optarg, NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (generate_count > 0u) {
+    return generate(preset, generate_count, seed);
+  }
+  if (optind >= argc) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  atomic_init(&totals.boards, 0u);
+  atomic_init(&totals.invalid, 0u);
+  atomic_init(&totals.bbbv, 0u);
+  totals.quiet = quiet;
+
+  struct timespec start;
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (!quiet) {
+    puts("file,line,3bv,openings,isolated,density");
+  }
+  MINESWEEPER_RESULT result = minesweeper_analyze_files(
+      (const char *const *)&argv[optind], (uint32_t)(argc - optind), threads,
+      print_analysis, &totals);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (double)(end.tv_sec - start.tv_sec) +
+                   ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+  uint64_t boards = atomic_load(&totals.boards);
+  fprintf(stderr, "%llu boards, %llu invalid, mean 3BV %.3f, %.0f boards/s\n",
+          (unsigned long long)boards,
+          (unsigned long long)atomic_load(&totals.invalid),
+          (boards > 0u) ? ((double)atomic_load(&totals.bbbv) / (double)boards)
+                        : 0.0,
+          (double)boards / seconds);
+  if (MINESWEEPER_RESULT_SUCCESS != result) {
+    fprintf(stderr, "Couldn't read every board file\n");
+    return EXIT_FAILURE;
+  }
+
+  return (0u == atomic_load(&totals.invalid)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
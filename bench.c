@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 199309L
+#include "minesweeper_board.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Number of different boards played per preset */
+#define BENCH_BOARDS (256u)
+/* Number of times each set of boards is played per timing */
+#define BENCH_ROUNDS (200u)
+/* Number of timings taken, the fastest is reported */
+#define BENCH_REPEATS (5u)
+
+static MINESWEEPER_STATE grid[MINESWEEPER_PRESET_MAX_SIZE];
+static MINESWEEPER_POINT mines[BENCH_BOARDS][MINESWEEPER_PRESET_MAX_MINES];
+static MINESWEEPER_POINT picks[BENCH_BOARDS][MINESWEEPER_PRESET_MAX_SIZE];
+
+/**
+ * @brief Small xorshift generator, so every run plays the same boards.
+ *
+ * @param state [in/out]    The generator state.
+ * @return uint32_t The next random number.
+ */
+static uint32_t bench_random(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+/**
+ * @brief Creates the mine layouts and the order every point is picked in for
+ * each board.
+ *
+ * @param board [in]    The board to generate for.
+ */
+static void bench_generate(const MINESWEEPER_BOARD *board) {
+  uint32_t seed = 0x2545F491u;
+  uint32_t size = (uint32_t)board->width * board->height;
+
+  for (uint32_t b = 0; b < BENCH_BOARDS; b++) {
+    /* Shuffle every point, the first mine_count points are the mines */
+    for (uint32_t i = 0; i < size; i++) {
+      picks[b][i].x = (minesweeper_coordinate)(i / board->height);
+      picks[b][i].y = (minesweeper_coordinate)(i % board->height);
+    }
+    for (uint32_t i = size - 1; i > 0; i--) {
+      uint32_t j = bench_random(&seed) % (i + 1);
+      MINESWEEPER_POINT tmp = picks[b][i];
+      picks[b][i] = picks[b][j];
+      picks[b][j] = tmp;
+    }
+    for (uint32_t i = 0; i < board->mine_count; i++) {
+      mines[b][i] = picks[b][i];
+    }
+    /* Pick in a different order to the mine placement */
+    for (uint32_t i = size - 1; i > 0; i--) {
+      uint32_t j = bench_random(&seed) % (i + 1);
+      MINESWEEPER_POINT tmp = picks[b][i];
+      picks[b][i] = picks[b][j];
+      picks[b][j] = tmp;
+    }
+  }
+}
+
+/**
+ * @brief Plays every generated board until it is won or lost.
+ *
+ * @param board [in/out]    The board to play on.
+ * @param moves [out]       The number of moves made.
+ * @return double The time taken in seconds.
+ */
+static double bench_play_once(MINESWEEPER_BOARD *board, uint64_t *moves) {
+  uint32_t size = (uint32_t)board->width * board->height;
+  struct timespec start;
+  struct timespec end;
+  *moves = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+    for (uint32_t b = 0; b < BENCH_BOARDS; b++) {
+      minesweeper_board_reset(board, mines[b]);
+      for (uint32_t i = 0; i < size; i++) {
+        MINESWEEPER_RESULT result = minesweeper_board_pick(board, &picks[b][i]);
+        (*moves)++;
+        if ((MINESWEEPER_RESULT_WIN == result) ||
+            (MINESWEEPER_RESULT_LOSE == result)) {
+          break;
+        }
+      }
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start.tv_sec) +
+         ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+}
+
+/**
+ * @brief Times playing every generated board, keeping the fastest run.
+ *
+ * @param board [in/out]    The board to play on.
+ * @return double The fastest time per move in seconds.
+ */
+static double bench_play(MINESWEEPER_BOARD *board) {
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < BENCH_REPEATS; i++) {
+    uint64_t moves = 0;
+    double time = bench_play_once(board, &moves) / (double)moves;
+    if ((0u == i) || (time < best)) {
+      best = time;
+    }
+  }
+
+  return best;
+}
+
+int main(void) {
+  printf("%-14s %12s %12s %8s\n", "preset", "preset ns", "generic ns",
+         "speedup");
+  for (uint32_t p = 0; p < MINESWEEPER_PRESET_CUSTOM; p++) {
+    MINESWEEPER_BOARD board;
+    if (MINESWEEPER_RESULT_SUCCESS !=
+        minesweeper_board_init_preset(&board, grid, (MINESWEEPER_PRESET)p)) {
+      printf("Failed to set up preset %s\n",
+             minesweeper_preset_name((MINESWEEPER_PRESET)p));
+      return EXIT_FAILURE;
+    }
+    bench_generate(&board);
+
+    double preset_time = bench_play(&board);
+    /* Same boards again, forced onto the generic engine */
+    board.preset = MINESWEEPER_PRESET_CUSTOM;
+    double generic_time = bench_play(&board);
+
+    printf("%-14s %12.2f %12.2f %7.2fx\n",
+           minesweeper_preset_name((MINESWEEPER_PRESET)p), preset_time * 1e9,
+           generic_time * 1e9, generic_time / preset_time);
+  }
+
+  return EXIT_SUCCESS;
+}
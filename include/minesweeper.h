@@ -1,3 +1,6 @@
+#ifndef MINESWEEPER_H
+#define MINESWEEPER_H
+
 #include <stdint.h>
 
 /**
@@ -26,6 +29,7 @@ typedef enum {
   MINESWEEPER_RESULT_LOSE,          /*! User has clicked on a mine and lost */
   MINESWEEPER_RESULT_WIN, /*! User has cleared all spaces without clicking on a
                              mine */
+  MINESWEEPER_RESULT_EMPTY, /*! No ready board was available */
 } MINESWEEPER_RESULT;
 
 /* Sets the game pragmatics */
@@ -80,3 +84,5 @@ MINESWEEPER_RESULT minesweeper_pick(
 MINESWEEPER_RESULT minesweeper_flag(
     MINESWEEPER_STATE grid[MINESWEEPER_BOARD_WIDTH][MINESWEEPER_BOARD_HEIGHT],
     MINESWEEPER_POINT *point);
+
+#endif /* MINESWEEPER_H */
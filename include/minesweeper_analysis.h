@@ -0,0 +1,107 @@
+#ifndef MINESWEEPER_ANALYSIS_H
+#define MINESWEEPER_ANALYSIS_H
+
+#include "minesweeper.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/* Value in the adjacency counts for a point which is itself a mine */
+#define MINESWEEPER_ADJACENT_MINE (0xFFu)
+
+/*
+ * Board file format
+ *
+ * A text file with one board per line, each a list of unsigned numbers
+ * separated by whitespace:
+ *
+ *   width height mine_count x0 y0 x1 y1 ...
+ *
+ * Blank lines and lines starting with '#' are skipped.
+ */
+
+/**
+ * @brief Difficulty measures for a board.
+ *
+ */
+typedef struct {
+  uint32_t bbbv;     /*! 3BV, the fewest clicks needed to clear the board if
+                        picking a zero point cascaded through its opening.
+                        Picks here never cascade, so it's only a measure of
+                        difficulty, not a click count for this engine */
+  uint32_t openings; /*! Connected regions of points with no adjacent mines */
+  uint32_t isolated; /*! Numbered points not bordering any opening */
+  uint32_t clear_points; /*! Points without a mine */
+  double density;        /*! Fraction of points which are mines */
+} MINESWEEPER_ANALYSIS;
+
+/**
+ * @brief Called with the analysis of each board read from a file.
+ *
+ * Called from several threads at once, so must be thread safe.
+ *
+ * @param path      [in]    The file the board was read from.
+ * @param line      [in]    The line the board was on, starting at 1.
+ * @param result    [in]    MINESWEEPER_RESULT_SUCCESS, or the reason the board
+ * was invalid.
+ * @param analysis  [in]    The analysis, only valid on success.
+ * @param context   [in]    The user context.
+ */
+typedef void (*MINESWEEPER_ANALYSIS_CALLBACK)(
+    const char *path, uint64_t line, MINESWEEPER_RESULT result,
+    const MINESWEEPER_ANALYSIS *analysis, void *context);
+
+/**
+ * @brief Analyses a board in time linear in its size.
+ *
+ * @param width         [in]    Number of columns.
+ * @param height        [in]    Number of rows.
+ * @param mine_count    [in]    Number of mines.
+ * @param mines         [in]    The location of each mine.
+ * @param adjacent      [out]   Optional, width * height adjacent mine counts
+ * laid out like MINESWEEPER_BOARD grids. Mines are set to
+ * MINESWEEPER_ADJACENT_MINE.
+ * @param analysis      [out]   The analysis.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_analyze(minesweeper_coordinate width,
+                                       minesweeper_coordinate height,
+                                       uint16_t mine_count,
+                                       const MINESWEEPER_POINT *mines,
+                                       uint8_t *adjacent,
+                                       MINESWEEPER_ANALYSIS *analysis);
+
+/**
+ * @brief Analyses every board in a set of board files, spread over threads.
+ *
+ * Files are split into chunks of whole lines, so even a single file is shared
+ * between every thread. Boards are reported in no particular order.
+ *
+ * @param paths     [in]    The board files.
+ * @param count     [in]    Number of board files.
+ * @param threads   [in]    Threads to use, 0 for one per core.
+ * @param callback  [in]    Called with each board's analysis.
+ * @param context   [in]    Passed to the callback.
+ * @return MINESWEEPER_RESULT MINESWEEPER_RESULT_SUCCESS if every file could be
+ * read, invalid boards are reported through the callback.
+ */
+MINESWEEPER_RESULT
+minesweeper_analyze_files(const char *const *paths, uint32_t count,
+                          uint32_t threads,
+                          MINESWEEPER_ANALYSIS_CALLBACK callback,
+                          void *context);
+
+/**
+ * @brief Writes a board as a line of a board file.
+ *
+ * @param file          [in]    The file to write to.
+ * @param width         [in]    Number of columns.
+ * @param height        [in]    Number of rows.
+ * @param mine_count    [in]    Number of mines.
+ * @param mines         [in]    The location of each mine.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_analysis_write_board(
+    FILE *file, minesweeper_coordinate width, minesweeper_coordinate height,
+    uint16_t mine_count, const MINESWEEPER_POINT *mines);
+
+#endif /* MINESWEEPER_ANALYSIS_H */
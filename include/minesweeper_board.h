@@ -0,0 +1,171 @@
+#ifndef MINESWEEPER_BOARD_H
+#define MINESWEEPER_BOARD_H
+
+#include "minesweeper.h"
+#include "minesweeper_events.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief The standard board presets, as (name, width, height, mine count).
+ *
+ * Each preset gets its own engine instantiation with the board size folded in
+ * at compile time. Beginner matches the fixed size used by minesweeper.h.
+ */
+#define MINESWEEPER_PRESETS(X)                                                 \
+  X(BEGINNER, MINESWEEPER_BOARD_WIDTH, MINESWEEPER_BOARD_HEIGHT,               \
+    MINESWEEPER_MINE_COUNT)                                                    \
+  X(INTERMEDIATE, 16u, 16u, 40u)                                               \
+  X(EXPERT, 30u, 16u, 99u)
+
+/* The largest preset, used to size fixed buffers */
+#define MINESWEEPER_PRESET_MAX_SIZE (30u * 16u)
+#define MINESWEEPER_PRESET_MAX_MINES (99u)
+
+#define MINESWEEPER_PRESET_ENUM(name, width, height, mines)                    \
+  MINESWEEPER_PRESET_##name,
+
+/**
+ * @brief Lists the engines a board can be played with.
+ *
+ */
+typedef enum {
+  MINESWEEPER_PRESETS(MINESWEEPER_PRESET_ENUM) /*! One per preset */
+  MINESWEEPER_PRESET_CUSTOM, /*! Any other size, uses the generic engine */
+} MINESWEEPER_PRESET;
+
+#undef MINESWEEPER_PRESET_ENUM
+
+/**
+ * @brief A runtime-sized game board.
+ *
+ * Unlike the functions in minesweeper.h, all game state lives in this struct
+ * so any number of boards can be played at once, one per thread. Errors are
+ * reported through the return codes only, nothing is printed.
+ *
+ * The grid is stored column-major like the 2D array used by minesweeper.h,
+ * i.e. point (x, y) is at grid[x * height + y].
+ */
+typedef struct {
+  MINESWEEPER_STATE *grid; /*! width * height states, managed by the user */
+  minesweeper_coordinate width;  /*! Number of columns */
+  minesweeper_coordinate height; /*! Number of rows */
+  uint16_t mine_count;           /*! Number of mines on the board */
+  uint16_t shown_points;         /*! Number of clear points revealed */
+  bool is_init;                  /*! Whether the board has been reset */
+  MINESWEEPER_PRESET preset; /*! Engine used for this board. Set to
+                                MINESWEEPER_PRESET_CUSTOM to force the generic
+                                engine. A preset that doesn't match the board
+                                size also uses the generic engine. */
+  MINESWEEPER_EVENT_RING *events; /*! Optional, every move is logged to this
+                                     ring when set */
+  uint64_t game_id; /*! ID of the current game in the event log */
+} MINESWEEPER_BOARD;
+
+/**
+ * @brief Looks up the preset for the given board size.
+ *
+ * @param width         [in]    Number of columns.
+ * @param height        [in]    Number of rows.
+ * @param mine_count    [in]    Number of mines.
+ * @return MINESWEEPER_PRESET The matching preset, or MINESWEEPER_PRESET_CUSTOM.
+ */
+MINESWEEPER_PRESET minesweeper_preset_find(minesweeper_coordinate width,
+                                           minesweeper_coordinate height,
+                                           uint16_t mine_count);
+
+/**
+ * @brief Gets the board size for a preset.
+ *
+ * @param preset        [in]    The preset.
+ * @param width         [out]   Number of columns.
+ * @param height        [out]   Number of rows.
+ * @param mine_count    [out]   Number of mines.
+ * @return MINESWEEPER_RESULT MINESWEEPER_RESULT_OUT_OF_BOUNDS if the preset
+ * has no fixed size, i.e. MINESWEEPER_PRESET_CUSTOM.
+ */
+MINESWEEPER_RESULT minesweeper_preset_size(MINESWEEPER_PRESET preset,
+                                           minesweeper_coordinate *width,
+                                           minesweeper_coordinate *height,
+                                           uint16_t *mine_count);
+
+/**
+ * @brief Looks up a preset by name, such as "beginner", in any case.
+ *
+ * @param name  [in]    The preset name.
+ * @return MINESWEEPER_PRESET The matching preset, or MINESWEEPER_PRESET_CUSTOM
+ * if no preset has that name.
+ */
+MINESWEEPER_PRESET minesweeper_preset_from_name(const char *name);
+
+/**
+ * @brief Gets the name of a preset.
+ *
+ * @param preset    [in]    The preset.
+ * @return const char* The name in upper case, such as "BEGINNER".
+ */
+const char *minesweeper_preset_name(MINESWEEPER_PRESET preset);
+
+/**
+ * @brief Sets up a board of the given size. The board must then be reset
+ * before it can be played.
+ *
+ * @param board         [out]   The board to set up.
+ * @param grid          [in]    Storage for width * height states. Must be
+ * memory managed by the user.
+ * @param width         [in]    Number of columns.
+ * @param height        [in]    Number of rows.
+ * @param mine_count    [in]    Number of mines.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_board_init(MINESWEEPER_BOARD *board,
+                                          MINESWEEPER_STATE *grid,
+                                          minesweeper_coordinate width,
+                                          minesweeper_coordinate height,
+                                          uint16_t mine_count);
+
+/**
+ * @brief Sets up a board using one of the standard presets.
+ *
+ * @param board     [out]   The board to set up.
+ * @param grid      [in]    Storage for the preset's width * height states.
+ * @param preset    [in]    The preset to use.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_board_init_preset(MINESWEEPER_BOARD *board,
+                                                 MINESWEEPER_STATE *grid,
+                                                 MINESWEEPER_PRESET preset);
+
+/**
+ * @brief Resets the board and places the mines. Equivalent to
+ * minesweeper_reset().
+ *
+ * @param board [in/out]    The board to reset.
+ * @param mines [in]        board->mine_count points describing the location of
+ * the mines.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_board_reset(MINESWEEPER_BOARD *board,
+                                           const MINESWEEPER_POINT *mines);
+
+/**
+ * @brief Picks a point on the board. Equivalent to minesweeper_pick().
+ *
+ * @param board [in/out]    The board to play.
+ * @param point [in]        The point to choose.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_board_pick(MINESWEEPER_BOARD *board,
+                                          const MINESWEEPER_POINT *point);
+
+/**
+ * @brief Flags a point on the board. Equivalent to minesweeper_flag().
+ *
+ * @param board [in/out]    The board to play.
+ * @param point [in]        The point to flag.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_board_flag(MINESWEEPER_BOARD *board,
+                                          const MINESWEEPER_POINT *point);
+
+#endif /* MINESWEEPER_BOARD_H */
@@ -0,0 +1,127 @@
+#ifndef MINESWEEPER_EVENTS_H
+#define MINESWEEPER_EVENTS_H
+
+#include "minesweeper.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Event log file format
+ *
+ * The file is a sequence of frames, each a 4 byte little endian payload length
+ * followed by that many bytes of records. Every record is
+ * MINESWEEPER_EVENT_RECORD_SIZE bytes, all fields little endian:
+ *
+ *   offset  size  field
+ *        0     8  timestamp, nanoseconds since the Unix epoch
+ *        8     8  game ID
+ *       16     2  revealed point count
+ *       18     1  event type (MINESWEEPER_EVENT_TYPE)
+ *       19     1  x coordinate
+ *       20     1  y coordinate
+ *       21     1  result (MINESWEEPER_RESULT)
+ *       22     2  reserved, always 0
+ */
+#define MINESWEEPER_EVENT_RECORD_SIZE (24u)
+
+/**
+ * @brief Lists the kinds of event that are logged.
+ *
+ */
+typedef enum {
+  MINESWEEPER_EVENT_GAME_START, /*! Board reset. x and y hold the board size */
+  MINESWEEPER_EVENT_PICK, /*! Point picked. Revealed is the number of clear
+                             points it revealed */
+  MINESWEEPER_EVENT_FLAG, /*! Point flagged */
+  MINESWEEPER_EVENT_GAME_END, /*! Game won or lost. Revealed is the total
+                                 number of clear points the player revealed,
+                                 before the losing pick on a loss */
+} MINESWEEPER_EVENT_TYPE;
+
+/**
+ * @brief A single logged event.
+ *
+ */
+typedef struct {
+  uint64_t timestamp; /*! Nanoseconds since the Unix epoch */
+  uint64_t game_id;   /*! Unique within the sink */
+  uint16_t revealed;  /*! Number of clear points revealed */
+  uint8_t type;       /*! MINESWEEPER_EVENT_TYPE */
+  minesweeper_coordinate x; /*! X coordinate of the point */
+  minesweeper_coordinate y; /*! Y coordinate of the point */
+  uint8_t result;           /*! MINESWEEPER_RESULT of the move */
+} MINESWEEPER_EVENT;
+
+/** Writes events to a file from a background thread */
+typedef struct MINESWEEPER_EVENT_SINK MINESWEEPER_EVENT_SINK;
+/** Single producer queue of events feeding a sink */
+typedef struct MINESWEEPER_EVENT_RING MINESWEEPER_EVENT_RING;
+
+/**
+ * @brief Opens a sink, creating or truncating the file, and starts its
+ * background flusher.
+ *
+ * @param path      [in]    The file to write events to.
+ * @param capacity  [in]    Number of events each ring can hold, rounded up to
+ * a power of 2.
+ * @return MINESWEEPER_EVENT_SINK* The sink, or NULL on failure.
+ */
+MINESWEEPER_EVENT_SINK *minesweeper_events_open(const char *path,
+                                                uint32_t capacity);
+
+/**
+ * @brief Creates a ring feeding the sink. Each thread logging events needs
+ * its own ring. Rings are freed once released, or when the sink is closed.
+ *
+ * @param sink  [in/out]    The sink to feed.
+ * @return MINESWEEPER_EVENT_RING* The ring, or NULL on failure.
+ */
+MINESWEEPER_EVENT_RING *minesweeper_events_ring(MINESWEEPER_EVENT_SINK *sink);
+
+/**
+ * @brief Hands a ring back to the sink once its thread is done logging. The
+ * flusher writes any events still queued and then frees the ring, so it must
+ * not be used again.
+ *
+ * @param ring  [in]    The ring to release.
+ */
+void minesweeper_events_ring_release(MINESWEEPER_EVENT_RING *ring);
+
+/**
+ * @brief Gets a new game ID, unique within the ring's sink.
+ *
+ * @param ring  [in/out]    The ring to get the ID from.
+ * @return uint64_t The game ID.
+ */
+uint64_t minesweeper_events_game_id(MINESWEEPER_EVENT_RING *ring);
+
+/**
+ * @brief Queues an event for writing. Never blocks, if the ring is full the
+ * event is dropped and counted instead.
+ *
+ * @param ring  [in/out]    The calling thread's ring.
+ * @param event [in]        The event to queue. The timestamp is filled in.
+ * @return true     The event was queued.
+ * @return false    The ring was full.
+ */
+bool minesweeper_events_push(MINESWEEPER_EVENT_RING *ring,
+                             MINESWEEPER_EVENT *event);
+
+/**
+ * @brief Gets the number of events dropped because a ring was full.
+ *
+ * @param sink  [in]    The sink.
+ * @return uint64_t The number of dropped events.
+ */
+uint64_t minesweeper_events_dropped(MINESWEEPER_EVENT_SINK *sink);
+
+/**
+ * @brief Stops the flusher, writes any queued events and closes the file.
+ * No ring may be used once this has been called.
+ *
+ * @param sink  [in]    The sink to close.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_events_close(MINESWEEPER_EVENT_SINK *sink);
+
+#endif /* MINESWEEPER_EVENTS_H */
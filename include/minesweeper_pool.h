@@ -0,0 +1,119 @@
+#ifndef MINESWEEPER_POOL_H
+#define MINESWEEPER_POOL_H
+
+#include "minesweeper_analysis.h"
+#include "minesweeper_board.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Number of presets the pool keeps boards for */
+#define MINESWEEPER_POOL_PRESETS ((uint32_t)MINESWEEPER_PRESET_CUSTOM)
+
+/**
+ * @brief A ready to play board, with everything precomputed.
+ *
+ */
+typedef struct {
+  uint64_t id;                      /*! Unique within the pool */
+  MINESWEEPER_PRESET preset;        /*! The preset the board is for */
+  MINESWEEPER_ANALYSIS analysis;    /*! Difficulty of the board */
+  MINESWEEPER_POINT mines[MINESWEEPER_PRESET_MAX_MINES]; /*! Mine locations */
+  uint8_t adjacent[MINESWEEPER_PRESET_MAX_SIZE]; /*! Adjacent mine counts, see
+                                                    minesweeper_analyze() */
+} MINESWEEPER_POOL_BOARD;
+
+/**
+ * @brief Describes how a pool is filled.
+ *
+ */
+typedef struct {
+  uint32_t capacity; /*! Boards kept ready per preset, rounded up to a power
+                        of 2 */
+  uint32_t threads;  /*! Refill threads, 0 for one per core */
+  uint64_t seed;     /*! Seed for the generated boards */
+  uint32_t min_bbbv[MINESWEEPER_POOL_PRESETS]; /*! Boards with a lower 3BV are
+                                                  thrown away */
+  uint32_t max_bbbv[MINESWEEPER_POOL_PRESETS]; /*! Boards with a higher 3BV
+                                                  are thrown away, 0 for no
+                                                  limit. Refill threads back
+                                                  off if few boards fit */
+} MINESWEEPER_POOL_CONFIG;
+
+/**
+ * @brief Counters for tuning a pool, per preset.
+ *
+ */
+typedef struct {
+  uint32_t depth[MINESWEEPER_POOL_PRESETS];     /*! Boards ready now */
+  uint64_t generated[MINESWEEPER_POOL_PRESETS]; /*! Boards added */
+  uint64_t rejected[MINESWEEPER_POOL_PRESETS];  /*! Boards outside the 3BV
+                                                   limits */
+  uint64_t popped[MINESWEEPER_POOL_PRESETS];    /*! Boards handed out */
+  uint64_t empty[MINESWEEPER_POOL_PRESETS]; /*! Requests with no board ready */
+  double refill_rate[MINESWEEPER_POOL_PRESETS]; /*! Boards one refill thread
+                                                   adds per second while
+                                                   generating, rejects
+                                                   included. Idle time isn't
+                                                   counted, so times threads
+                                                   this is the capacity */
+} MINESWEEPER_POOL_STATS;
+
+/** Keeps boards ready for every preset, refilled in the background */
+typedef struct MINESWEEPER_POOL MINESWEEPER_POOL;
+
+/**
+ * @brief Creates a pool and starts its refill threads. Refill threads sleep
+ * while every queue is full, until one drops below half full.
+ *
+ * @param config    [in]    How to fill the pool.
+ * @return MINESWEEPER_POOL* The pool, or NULL on failure or if a min_bbbv is
+ * above its max_bbbv.
+ */
+MINESWEEPER_POOL *
+minesweeper_pool_create(const MINESWEEPER_POOL_CONFIG *config);
+
+/**
+ * @brief Takes a ready board from the pool. Never waits for a board to be
+ * generated, and only takes a lock to wake sleeping refill threads when the
+ * queue runs low.
+ *
+ * @param pool      [in/out]    The pool.
+ * @param preset    [in]        The preset to take a board for.
+ * @param board     [out]       The board.
+ * @return true     A board was taken.
+ * @return false    No board was ready.
+ */
+bool minesweeper_pool_pop(MINESWEEPER_POOL *pool, MINESWEEPER_PRESET preset,
+                          MINESWEEPER_POOL_BOARD *board);
+
+/**
+ * @brief Starts a new game on a board using a ready board from the pool.
+ *
+ * @param pool      [in/out]    The pool.
+ * @param board     [in/out]    The board to reset. Must be a preset size.
+ * @param ready     [out]       Optional, the board taken from the pool.
+ * @return MINESWEEPER_RESULT MINESWEEPER_RESULT_OUT_OF_BOUNDS if the board
+ * isn't a preset size, MINESWEEPER_RESULT_EMPTY if no board was ready,
+ * otherwise the result of minesweeper_board_reset().
+ */
+MINESWEEPER_RESULT minesweeper_pool_new_game(MINESWEEPER_POOL *pool,
+                                             MINESWEEPER_BOARD *board,
+                                             MINESWEEPER_POOL_BOARD *ready);
+
+/**
+ * @brief Gets the pool's counters.
+ *
+ * @param pool  [in]    The pool.
+ * @param stats [out]   The counters.
+ */
+void minesweeper_pool_stats(MINESWEEPER_POOL *pool,
+                            MINESWEEPER_POOL_STATS *stats);
+
+/**
+ * @brief Stops the refill threads and frees the pool.
+ *
+ * @param pool  [in]    The pool.
+ */
+void minesweeper_pool_destroy(MINESWEEPER_POOL *pool);
+
+#endif /* MINESWEEPER_POOL_H */
@@ -0,0 +1,63 @@
+#ifndef MINESWEEPER_RANDOM_H
+#define MINESWEEPER_RANDOM_H
+
+#include "minesweeper.h"
+#include <stdint.h>
+
+/**
+ * @brief State for a xoshiro256** random number generator.
+ *
+ * Each generator is a separate stream, so one can be given to each thread
+ * without any locking.
+ */
+typedef struct {
+  uint64_t state[4];
+} MINESWEEPER_RANDOM;
+
+/**
+ * @brief Seeds a generator.
+ *
+ * Generators with the same seed but a different stream never overlap, so a
+ * single seed can be shared out between threads using the thread index as the
+ * stream.
+ *
+ * @param rng       [out]   The generator to seed.
+ * @param seed      [in]    The seed.
+ * @param stream    [in]    Which stream of the seed to use.
+ */
+void minesweeper_random_seed(MINESWEEPER_RANDOM *rng, uint64_t seed,
+                             uint32_t stream);
+
+/**
+ * @brief Gets the next random number.
+ *
+ * @param rng   [in/out]    The generator.
+ * @return uint64_t The random number.
+ */
+uint64_t minesweeper_random_next(MINESWEEPER_RANDOM *rng);
+
+/**
+ * @brief Gets a random number in the range [0, bound).
+ *
+ * @param rng   [in/out]    The generator.
+ * @param bound [in]        The exclusive upper bound. Must not be 0.
+ * @return uint32_t The random number.
+ */
+uint32_t minesweeper_random_below(MINESWEEPER_RANDOM *rng, uint32_t bound);
+
+/**
+ * @brief Picks a random set of distinct mine locations.
+ *
+ * @param rng           [in/out]    The generator.
+ * @param width         [in]        Number of columns.
+ * @param height        [in]        Number of rows.
+ * @param mine_count    [in]        Number of mines. Must be less than
+ * width * height.
+ * @param mines         [out]       mine_count points to fill in.
+ */
+void minesweeper_random_mines(MINESWEEPER_RANDOM *rng,
+                              minesweeper_coordinate width,
+                              minesweeper_coordinate height,
+                              uint16_t mine_count, MINESWEEPER_POINT *mines);
+
+#endif /* MINESWEEPER_RANDOM_H */
@@ -0,0 +1,129 @@
+#ifndef MINESWEEPER_SIM_H
+#define MINESWEEPER_SIM_H
+
+#include "minesweeper_board.h"
+#include "minesweeper_random.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The most points a single pick can reveal, the point and its 8 neighbours */
+#define MINESWEEPER_SIM_MAX_CASCADE (9u)
+
+/**
+ * @brief A move chosen by a strategy.
+ *
+ */
+typedef struct {
+  MINESWEEPER_POINT point; /*! The point to pick or flag */
+  bool is_flag;            /*! Flag the point instead of picking it */
+  bool is_guess; /*! The strategy couldn't be sure the point is clear */
+} MINESWEEPER_SIM_MOVE;
+
+/**
+ * @brief What a player can see of a point.
+ *
+ */
+typedef enum {
+  MINESWEEPER_SIM_VIEW_HIDDEN,  /*! Not revealed, may or may not be a mine */
+  MINESWEEPER_SIM_VIEW_FLAGGED, /*! Not revealed, flagged by the player */
+  MINESWEEPER_SIM_VIEW_CLEAR,   /*! A revealed clear point */
+  MINESWEEPER_SIM_VIEW_MINE,    /*! A revealed mine */
+} MINESWEEPER_SIM_VIEW_STATE;
+
+/**
+ * @brief A player's view of the board being played, with the mines masked
+ * until they're revealed.
+ *
+ */
+typedef struct {
+  const uint8_t *points; /*! width * height MINESWEEPER_SIM_VIEW_STATE values,
+                            laid out like MINESWEEPER_BOARD grids */
+  minesweeper_coordinate width;  /*! Number of columns */
+  minesweeper_coordinate height; /*! Number of rows */
+  uint16_t mine_count;           /*! Number of mines on the board */
+  uint16_t shown_points;         /*! Number of clear points revealed */
+} MINESWEEPER_SIM_VIEW;
+
+/**
+ * @brief Chooses the next move to make.
+ *
+ * Called from several threads at once, each with its own view and generator.
+ *
+ * @param view      [in]    The player's view of the board being played.
+ * @param rng       [in/out]    The generator for the calling thread.
+ * @param context   [in]    The user context from MINESWEEPER_SIM_CONFIG.
+ * @param move      [out]   The move to make.
+ * @return true     A move was chosen.
+ * @return false    The strategy gives up on this game.
+ */
+typedef bool (*MINESWEEPER_SIM_STRATEGY)(const MINESWEEPER_SIM_VIEW *view,
+                                         MINESWEEPER_RANDOM *rng,
+                                         void *context,
+                                         MINESWEEPER_SIM_MOVE *move);
+
+/**
+ * @brief Describes a simulation run.
+ *
+ */
+typedef struct {
+  minesweeper_coordinate width;  /*! Number of columns */
+  minesweeper_coordinate height; /*! Number of rows */
+  uint16_t mine_count;           /*! Number of mines */
+  uint64_t games;                /*! Total number of games to play */
+  uint32_t threads;              /*! Threads to use, 0 for one per core */
+  uint64_t seed;                 /*! Seed for the boards and strategies */
+  MINESWEEPER_SIM_STRATEGY strategy; /*! Chooses each move */
+  void *context;                     /*! Passed to the strategy */
+  MINESWEEPER_EVENT_SINK *events;    /*! Optional, logs every move */
+} MINESWEEPER_SIM_CONFIG;
+
+/**
+ * @brief Results collected over a simulation run.
+ *
+ */
+typedef struct {
+  uint64_t games;   /*! Games played */
+  uint64_t wins;    /*! Games won */
+  uint64_t losses;  /*! Games lost */
+  uint64_t resigns; /*! Games the strategy gave up on */
+  uint64_t errors;  /*! Moves rejected by the engine, which end the game */
+  uint64_t picks;   /*! Points picked */
+  uint64_t flags;   /*! Points flagged */
+  uint64_t guesses; /*! Picks the strategy marked as a guess */
+  uint64_t revealed; /*! Clear points revealed by picks */
+  uint64_t cascades[MINESWEEPER_SIM_MAX_CASCADE + 1u]; /*! Number of picks
+                                                          revealing each
+                                                          number of clear
+                                                          points */
+  uint32_t max_moves; /*! Most moves made in a single game */
+} MINESWEEPER_SIM_STATS;
+
+/**
+ * @brief Plays random boards with the given strategy, spread over threads.
+ *
+ * Each thread uses its own stream of the seed, so a run is repeatable for the
+ * same seed and thread count.
+ *
+ * @param config    [in]    The simulation to run.
+ * @param stats     [out]   The combined results of all threads.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+MINESWEEPER_RESULT minesweeper_sim_run(const MINESWEEPER_SIM_CONFIG *config,
+                                       MINESWEEPER_SIM_STATS *stats);
+
+/**
+ * @brief Strategy which picks a random hidden point each move.
+ */
+bool minesweeper_sim_strategy_random(const MINESWEEPER_SIM_VIEW *view,
+                                     MINESWEEPER_RANDOM *rng, void *context,
+                                     MINESWEEPER_SIM_MOVE *move);
+
+/**
+ * @brief Strategy which picks the hidden point that would reveal the most
+ * hidden points around it, breaking ties randomly.
+ */
+bool minesweeper_sim_strategy_greedy(const MINESWEEPER_SIM_VIEW *view,
+                                     MINESWEEPER_RANDOM *rng, void *context,
+                                     MINESWEEPER_SIM_MOVE *move);
+
+#endif /* MINESWEEPER_SIM_H */
@@ -0,0 +1,39 @@
+#ifndef MINESWEEPER_THREADS_H
+#define MINESWEEPER_THREADS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The function each thread runs, see pthread_create().
+ *
+ * @param arg   [in/out]    The thread's own argument.
+ * @return void* Ignored.
+ */
+typedef void *(*MINESWEEPER_THREADS_WORKER)(void *arg);
+
+/**
+ * @brief Works out how many threads to use.
+ *
+ * @param threads   [in]    Threads asked for, 0 for one per core.
+ * @param work      [in]    Number of pieces the work can be split into.
+ * @return uint32_t The number of threads, at least 1 and at most work.
+ */
+uint32_t minesweeper_threads_count(uint32_t threads, uint64_t work);
+
+/**
+ * @brief Runs a worker on several threads and waits for them all to finish.
+ *
+ * The calling thread runs the first argument itself. If a thread can't be
+ * started, its argument is run on the calling thread instead, so every
+ * argument is always run exactly once.
+ *
+ * @param worker    [in]        The function to run.
+ * @param args      [in/out]    An array of count arguments, one per thread.
+ * @param arg_size  [in]        Size of each argument in bytes.
+ * @param count     [in]        Number of threads.
+ */
+void minesweeper_threads_run(MINESWEEPER_THREADS_WORKER worker, void *args,
+                             size_t arg_size, uint32_t count);
+
+#endif /* MINESWEEPER_THREADS_H */
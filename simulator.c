@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Events each simulator thread can queue before they start being dropped */
+#define EVENTS_CAPACITY (1u << 16)
+
+/**
+ * @brief Prints how to use the simulator.
+ *
+ * @param name  [in]    The name the program was run as.
+ */
+static void usage(const char *name) {
+  printf("Usage: %s [-p preset] [-w width -h height -m mines] [-g games]\n"
+         "          [-s strategy] [-j threads] [-S seed] [-e file]\n"
+         "\n"
+         "  -p  beginner (default), intermediate or expert\n"
+         "  -w, -h, -m  custom board size, instead of a preset\n"
+         "  -g  number of games to play (default 1000000)\n"
+         "  -s  random (default) or greedy\n"
+         "  -j  number of threads (default one per core)\n"
+         "  -S  seed (default 1)\n"
+         "  -e  log every move to this event log file\n",
+         name);
+}
+
+int main(int argc, char *argv[]) {
+  MINESWEEPER_SIM_CONFIG config = {0};
+  MINESWEEPER_SIM_STATS stats;
+  MINESWEEPER_PRESET preset = MINESWEEPER_PRESET_BEGINNER;
+  const char *events_path = NULL;
+  int opt;
+
+  minesweeper_preset_size(preset, &config.width, &config.height,
+                          &config.mine_count);
+  config.games = 1000000u;
+  config.seed = 1u;
+  config.strategy = minesweeper_sim_strategy_random;
+
+  while ((opt = getopt(argc, argv, "p:w:h:m:g:s:j:S:e:")) != -1) {
+    switch (opt) {
+    case 'p':
+      preset = minesweeper_preset_from_name(optarg);
+      if (MINESWEEPER_RESULT_SUCCESS !=
+          minesweeper_preset_size(preset, &config.width, &config.height,
+                                  &config.mine_count)) {
+        printf("Unknown preset '%s'\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'w':
+      config.width = (minesweeper_coordinate)strtoul(optarg, NULL, 0);
+      break;
+    case 'h':
+      config.height = (minesweeper_coordinate)strtoul(optarg, NULL, 0);
+      break;
+    case 'm':
+      config.mine_count = (uint16_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'g':
+      config.games = strtoull(optarg, NULL, 0);
+      break;
+    case 's':
+      if (0 == strcasecmp(optarg, "random")) {
+        config.strategy = minesweeper_sim_strategy_random;
+      } else if (0 == strcasecmp(optarg, "greedy")) {
+        config.strategy = minesweeper_sim_strategy_greedy;
+      } else {
+        printf("Unknown strategy '%s'\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'j':
+      config.threads = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'S':
+      config.seed = strtoull(optarg, NULL, 0);
+      break;
+    case 'e':
+      events_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (NULL != events_path) {
+    config.events = minesweeper_events_open(events_path, EVENTS_CAPACITY);
+    if (NULL == config.events) {
+      printf("Couldn't open event log '%s'\n", events_path);
+      return EXIT_FAILURE;
+    }
+  }
+
+  struct timespec start;
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  MINESWEEPER_RESULT result = minesweeper_sim_run(&config, &stats);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  uint64_t dropped = 0;
+  if (NULL != config.events) {
+    dropped = minesweeper_events_dropped(config.events);
+    MINESWEEPER_RESULT close_result = minesweeper_events_close(config.events);
+    if ((MINESWEEPER_RESULT_SUCCESS != close_result) &&
+        (MINESWEEPER_RESULT_SUCCESS == result)) {
+      printf("Failed to write event log '%s'\n", events_path);
+      result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+    }
+  }
+  if (MINESWEEPER_RESULT_SUCCESS != result) {
+    printf("Got error code: %u\n", result);
+    return EXIT_FAILURE;
+  }
+
+  double seconds = (double)(end.tv_sec - start.tv_sec) +
+                   ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+  double games = (stats.games > 0u) ? (double)stats.games : 1.0;
+  double picks = (stats.picks > 0u) ? (double)stats.picks : 1.0;
+
+  printf("Board:          %ux%u, %u mines\n", config.width, config.height,
+         config.mine_count);
+  printf("Games:          %llu in %.3f s (%.0f games/min)\n",
+         (unsigned long long)stats.games, seconds,
+         (double)stats.games * 60.0 / seconds);
+  printf("Win rate:       %.4f%%\n", 100.0 * (double)stats.wins / games);
+  printf("Losses:         %llu\n", (unsigned long long)stats.losses);
+  printf("Resigns:        %llu\n", (unsigned long long)stats.resigns);
+  printf("Errors:         %llu\n", (unsigned long long)stats.errors);
+  printf("Moves per game: %.3f (max %u)\n",
+         (double)(stats.picks + stats.flags) / games, stats.max_moves);
+  printf("Guesses/game:   %.3f\n", (double)stats.guesses / games);
+  printf("Cascade size:   %.3f\n", (double)stats.revealed / picks);
+  for (uint32_t i = 0; i <= MINESWEEPER_SIM_MAX_CASCADE; i++) {
+    printf("  %u revealed: %llu\n", i, (unsigned long long)stats.cascades[i]);
+  }
+  if (NULL != events_path) {
+    printf("Events dropped: %llu\n", (unsigned long long)dropped);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,484 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_analysis.h"
+#include "minesweeper_threads.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+/* The largest board that fits in minesweeper_coordinate */
+#define ANALYSIS_MAX_POINTS (UINT8_MAX * UINT8_MAX)
+/* Files are shared out in chunks of about this many bytes of whole lines */
+#define ANALYSIS_CHUNK_BYTES (64 * 1024)
+/* Bytes read at a time when splitting a file into chunks */
+#define ANALYSIS_SCAN_BYTES (16u * 1024u)
+
+/* Scratch space for each thread, so analysing a board never allocates */
+static _Thread_local uint8_t analysis_adjacent[ANALYSIS_MAX_POINTS];
+static _Thread_local uint16_t analysis_parent[ANALYSIS_MAX_POINTS];
+
+/**
+ * @brief A run of whole lines from a board file.
+ *
+ */
+typedef struct {
+  uint32_t file;       /*! Index of the board file */
+  off_t start;         /*! Offset of the first line */
+  off_t end;           /*! Offset just past the last line */
+  uint64_t first_line; /*! Number of the first line, starting at 1 */
+} ANALYSIS_CHUNK;
+
+/**
+ * @brief Everything a single batch analysis thread needs.
+ *
+ */
+typedef struct {
+  const char *const *paths;               /*! The board files */
+  const ANALYSIS_CHUNK *chunks;           /*! The chunks of every file */
+  size_t chunk_count;                     /*! Number of chunks */
+  atomic_size_t *next;                    /*! Next chunk to analyse */
+  MINESWEEPER_ANALYSIS_CALLBACK callback; /*! Called for every board */
+  void *context;                          /*! Passed to the callback */
+  MINESWEEPER_RESULT result;              /*! Result of the thread */
+} ANALYSIS_WORKER;
+
+/**
+ * @brief Finds the root of a set of zero points, halving the path as it goes.
+ *
+ * @param parent    [in/out]    The parent of each point.
+ * @param index     [in]        The point to find the root of.
+ * @return uint32_t The root point.
+ */
+static uint32_t analysis_find(uint16_t *parent, uint32_t index) {
+  while (parent[index] != index) {
+    parent[index] = parent[parent[index]];
+    index = parent[index];
+  }
+  return index;
+}
+
+/**
+ * @brief Joins the sets of zero points containing the two points.
+ *
+ * @param parent    [in/out]    The parent of each point.
+ * @param a         [in]        A point in the first set.
+ * @param b         [in]        A point in the second set.
+ * @return true     The sets were joined.
+ * @return false    The points were already in the same set.
+ */
+static bool analysis_union(uint16_t *parent, uint32_t a, uint32_t b) {
+  uint32_t root_a = analysis_find(parent, a);
+  uint32_t root_b = analysis_find(parent, b);
+
+  if (root_a == root_b) {
+    return false;
+  }
+  /* Always keep the lowest index as the root */
+  if (root_a < root_b) {
+    parent[root_b] = (uint16_t)root_a;
+  } else {
+    parent[root_a] = (uint16_t)root_b;
+  }
+  return true;
+}
+
+MINESWEEPER_RESULT minesweeper_analyze(minesweeper_coordinate width,
+                                       minesweeper_coordinate height,
+                                       uint16_t mine_count,
+                                       const MINESWEEPER_POINT *mines,
+                                       uint8_t *adjacent,
+                                       MINESWEEPER_ANALYSIS *analysis) {
+  uint32_t size = (uint32_t)width * height;
+  uint8_t *adj = (NULL != adjacent) ? adjacent : analysis_adjacent;
+  uint16_t *parent = analysis_parent;
+
+  if ((NULL == analysis) || ((NULL == mines) && (mine_count > 0u))) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  if ((0u == size) || (mine_count >= size)) {
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+
+  /* Place the mines, then count them around every other point */
+  memset(adj, 0, size);
+  for (uint32_t i = 0; i < mine_count; i++) {
+    if ((mines[i].x >= width) || (mines[i].y >= height)) {
+      return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+    }
+    uint32_t index = ((uint32_t)mines[i].x * height) + mines[i].y;
+    if (MINESWEEPER_ADJACENT_MINE == adj[index]) {
+      /* Duplicate mine */
+      return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+    }
+    adj[index] = MINESWEEPER_ADJACENT_MINE;
+  }
+  for (uint32_t i = 0; i < mine_count; i++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      uint32_t x = (minesweeper_coordinate)(mines[i].x + dx);
+      for (int dy = -1; (dy <= 1) && (x < width); dy++) {
+        uint32_t y = (minesweeper_coordinate)(mines[i].y + dy);
+        if ((y < height) &&
+            (MINESWEEPER_ADJACENT_MINE != adj[(x * height) + y])) {
+          adj[(x * height) + y]++;
+        }
+      }
+    }
+  }
+
+  /*
+   * Label the openings in a single pass, joining each zero point with the
+   * zero points before it: (x, y - 1) and the three points in column x - 1.
+   */
+  uint32_t openings = 0;
+  for (uint32_t x = 0; x < width; x++) {
+    for (uint32_t y = 0; y < height; y++) {
+      uint32_t index = (x * height) + y;
+      if (0u != adj[index]) {
+        continue;
+      }
+      parent[index] = (uint16_t)index;
+      openings++;
+
+      if ((y > 0u) && (0u == adj[index - 1u]) &&
+          analysis_union(parent, index, index - 1u)) {
+        openings--;
+      }
+      if (x > 0u) {
+        for (uint32_t j = (y > 0u) ? (y - 1u) : 0u;
+             (j <= y + 1u) && (j < height); j++) {
+          uint32_t before = ((x - 1u) * height) + j;
+          if ((0u == adj[before]) && analysis_union(parent, index, before)) {
+            openings--;
+          }
+        }
+      }
+    }
+  }
+
+  /* Numbered points which no opening will reveal each need their own click */
+  uint32_t isolated = 0;
+  for (uint32_t x = 0; x < width; x++) {
+    for (uint32_t y = 0; y < height; y++) {
+      uint8_t count = adj[(x * height) + y];
+      if ((0u == count) || (MINESWEEPER_ADJACENT_MINE == count)) {
+        continue;
+      }
+      bool borders_opening = false;
+      for (uint32_t i = (x > 0u) ? (x - 1u) : 0u;
+           (i <= x + 1u) && (i < width) && !borders_opening; i++) {
+        for (uint32_t j = (y > 0u) ? (y - 1u) : 0u;
+             (j <= y + 1u) && (j < height); j++) {
+          if (0u == adj[(i * height) + j]) {
+            borders_opening = true;
+            break;
+          }
+        }
+      }
+      isolated += !borders_opening;
+    }
+  }
+
+  analysis->openings = openings;
+  analysis->isolated = isolated;
+  analysis->bbbv = openings + isolated;
+  analysis->clear_points = size - mine_count;
+  analysis->density = (double)mine_count / (double)size;
+
+  return MINESWEEPER_RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reads the next number from a board file line.
+ *
+ * @param cursor    [in/out]    Position in the line, moved past the number.
+ * @param max_value [in]        The largest allowed value.
+ * @param value     [out]       The number read.
+ * @return true     A valid number was read.
+ * @return false    There was no number or it was too large.
+ */
+static bool analysis_read_number(char **cursor, unsigned long max_value,
+                                 unsigned long *value) {
+  char *end;
+
+  errno = 0;
+  *value = strtoul(*cursor, &end, 10);
+  if ((end == *cursor) || (0 != errno) || (*value > max_value)) {
+    return false;
+  }
+  *cursor = end;
+  return true;
+}
+
+/**
+ * @brief Reads a board from a line of a board file.
+ *
+ * @param line          [in]    The line to read.
+ * @param width         [out]   Number of columns.
+ * @param height        [out]   Number of rows.
+ * @param mine_count    [out]   Number of mines.
+ * @param mines         [out]   Storage for up to UINT16_MAX mines.
+ * @return true     The line held a board.
+ * @return false    The line was badly formed.
+ */
+static bool analysis_parse(char *line, minesweeper_coordinate *width,
+                           minesweeper_coordinate *height,
+                           uint16_t *mine_count, MINESWEEPER_POINT *mines) {
+  unsigned long values[3];
+  char *cursor = line;
+
+  if (!analysis_read_number(&cursor, UINT8_MAX, &values[0]) ||
+      !analysis_read_number(&cursor, UINT8_MAX, &values[1]) ||
+      !analysis_read_number(&cursor, UINT16_MAX, &values[2])) {
+    return false;
+  }
+  *width = (minesweeper_coordinate)values[0];
+  *height = (minesweeper_coordinate)values[1];
+  *mine_count = (uint16_t)values[2];
+
+  for (uint32_t i = 0; i < *mine_count; i++) {
+    if (!analysis_read_number(&cursor, UINT8_MAX, &values[0]) ||
+        !analysis_read_number(&cursor, UINT8_MAX, &values[1])) {
+      return false;
+    }
+    mines[i].x = (minesweeper_coordinate)values[0];
+    mines[i].y = (minesweeper_coordinate)values[1];
+  }
+
+  /* Nothing but whitespace may follow */
+  while ((' ' == *cursor) || ('\t' == *cursor) || ('\r' == *cursor) ||
+         ('\n' == *cursor)) {
+    cursor++;
+  }
+  return '\0' == *cursor;
+}
+
+/**
+ * @brief Adds a chunk to the list, growing it as needed.
+ *
+ * @param chunks    [in/out]    The list of chunks.
+ * @param count     [in/out]    Number of chunks in the list.
+ * @param capacity  [in/out]    Number of chunks the list has room for.
+ * @param chunk     [in]        The chunk to add.
+ * @return true     The chunk was added.
+ * @return false    There wasn't enough memory.
+ */
+static bool analysis_add_chunk(ANALYSIS_CHUNK **chunks, size_t *count,
+                               size_t *capacity, const ANALYSIS_CHUNK *chunk) {
+  if (*count == *capacity) {
+    size_t grown = (0u == *capacity) ? 16u : (*capacity * 2u);
+    ANALYSIS_CHUNK *larger = realloc(*chunks, grown * sizeof(*larger));
+    if (NULL == larger) {
+      return false;
+    }
+    *chunks = larger;
+    *capacity = grown;
+  }
+  (*chunks)[(*count)++] = *chunk;
+  return true;
+}
+
+/**
+ * @brief Splits a board file into chunks of whole lines, so one large file can
+ * be shared between every thread. Only looks for newlines, which is far
+ * quicker than parsing the boards.
+ *
+ * @param path      [in]        The board file.
+ * @param file      [in]        Index of the board file.
+ * @param chunks    [in/out]    The list of chunks to add to.
+ * @param count     [in/out]    Number of chunks in the list.
+ * @param capacity  [in/out]    Number of chunks the list has room for.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+static MINESWEEPER_RESULT analysis_split(const char *path, uint32_t file,
+                                         ANALYSIS_CHUNK **chunks,
+                                         size_t *count, size_t *capacity) {
+  char buffer[ANALYSIS_SCAN_BYTES];
+  ANALYSIS_CHUNK chunk = {file, 0, 0, 1u};
+  FILE *stream = fopen(path, "rb");
+  off_t offset = 0;
+  uint64_t lines = 0;
+  bool ok = true;
+  size_t read;
+
+  if (NULL == stream) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+
+  while (ok && ((read = fread(buffer, 1u, sizeof(buffer), stream)) > 0u)) {
+    for (const char *newline = memchr(buffer, '\n', read); NULL != newline;
+         newline = memchr(newline + 1, '\n',
+                          read - (size_t)(newline + 1 - buffer))) {
+      off_t after = offset + (newline - buffer) + 1;
+      lines++;
+      if ((after - chunk.start) >= ANALYSIS_CHUNK_BYTES) {
+        chunk.end = after;
+        ok = analysis_add_chunk(chunks, count, capacity, &chunk);
+        chunk.start = after;
+        chunk.first_line = lines + 1u;
+      }
+    }
+    offset += (off_t)read;
+  }
+  /* Whatever is left, including a last line without a newline */
+  if (ok && (offset > chunk.start)) {
+    chunk.end = offset;
+    ok = analysis_add_chunk(chunks, count, capacity, &chunk);
+  }
+  ok = ok && !ferror(stream);
+
+  fclose(stream);
+  return ok ? MINESWEEPER_RESULT_SUCCESS : MINESWEEPER_RESULT_UNKNOWN_ERR;
+}
+
+/**
+ * @brief Analyses every board in one chunk of a file.
+ *
+ * @param worker    [in]    The thread doing the analysis.
+ * @param chunk     [in]    The chunk to analyse.
+ * @param mines     [out]   Storage for up to UINT16_MAX mines.
+ * @return MINESWEEPER_RESULT The return code.
+ */
+static MINESWEEPER_RESULT analysis_chunk(const ANALYSIS_WORKER *worker,
+                                         const ANALYSIS_CHUNK *chunk,
+                                         MINESWEEPER_POINT *mines) {
+  const char *path = worker->paths[chunk->file];
+  FILE *file = fopen(path, "r");
+  char *line = NULL;
+  size_t capacity = 0;
+  uint64_t number = chunk->first_line;
+  off_t offset = chunk->start;
+  ssize_t length;
+
+  if (NULL == file) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  if (0 != fseeko(file, chunk->start, SEEK_SET)) {
+    fclose(file);
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+
+  for (; (offset < chunk->end) &&
+         ((length = getline(&line, &capacity, file)) != -1);
+       number++) {
+    MINESWEEPER_ANALYSIS analysis;
+    minesweeper_coordinate width;
+    minesweeper_coordinate height;
+    uint16_t mine_count;
+    MINESWEEPER_RESULT result = MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+    char *start = line + strspn(line, " \t\r\n");
+
+    offset += length;
+    if (('\0' == *start) || ('#' == *start)) {
+      continue;
+    }
+    if (analysis_parse(start, &width, &height, &mine_count, mines)) {
+      result = minesweeper_analyze(width, height, mine_count, mines, NULL,
+                                   &analysis);
+    }
+    worker->callback(path, number, result, &analysis, worker->context);
+  }
+
+  free(line);
+  fclose(file);
+  return MINESWEEPER_RESULT_SUCCESS;
+}
+
+/**
+ * @brief Analyses chunks until there are none left.
+ *
+ * @param arg   [in/out]    The ANALYSIS_WORKER for the thread.
+ * @return void* Always NULL, the result is stored in the worker.
+ */
+static void *analysis_worker(void *arg) {
+  ANALYSIS_WORKER *worker = arg;
+  MINESWEEPER_POINT *mines = malloc(UINT16_MAX * sizeof(*mines));
+
+  worker->result = MINESWEEPER_RESULT_SUCCESS;
+  if (NULL == mines) {
+    worker->result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+    return NULL;
+  }
+
+  /* Chunks are shared out, so each board is only read once */
+  for (size_t i = atomic_fetch_add(worker->next, 1u); i < worker->chunk_count;
+       i = atomic_fetch_add(worker->next, 1u)) {
+    MINESWEEPER_RESULT result =
+        analysis_chunk(worker, &worker->chunks[i], mines);
+    if (MINESWEEPER_RESULT_SUCCESS != result) {
+      worker->result = result;
+    }
+  }
+
+  free(mines);
+  return NULL;
+}
+
+MINESWEEPER_RESULT
+minesweeper_analyze_files(const char *const *paths, uint32_t count,
+                          uint32_t threads,
+                          MINESWEEPER_ANALYSIS_CALLBACK callback,
+                          void *context) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+  ANALYSIS_CHUNK *chunks = NULL;
+  size_t chunk_count = 0;
+  size_t chunk_capacity = 0;
+  atomic_size_t next;
+
+  if ((NULL == paths) || (NULL == callback)) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  atomic_init(&next, 0u);
+
+  /* Files which can't be read are reported, the rest are still analysed */
+  for (uint32_t i = 0; i < count; i++) {
+    MINESWEEPER_RESULT split =
+        analysis_split(paths[i], i, &chunks, &chunk_count, &chunk_capacity);
+    if (MINESWEEPER_RESULT_SUCCESS != split) {
+      result = split;
+    }
+  }
+
+  threads = minesweeper_threads_count(threads, chunk_count);
+  ANALYSIS_WORKER *workers = calloc(threads, sizeof(*workers));
+  if (NULL == workers) {
+    free(chunks);
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  for (uint32_t i = 0; i < threads; i++) {
+    workers[i].paths = paths;
+    workers[i].chunks = chunks;
+    workers[i].chunk_count = chunk_count;
+    workers[i].next = &next;
+    workers[i].callback = callback;
+    workers[i].context = context;
+  }
+  minesweeper_threads_run(analysis_worker, workers, sizeof(*workers), threads);
+
+  for (uint32_t i = 0; i < threads; i++) {
+    if (MINESWEEPER_RESULT_SUCCESS != workers[i].result) {
+      result = workers[i].result;
+    }
+  }
+
+  free(workers);
+  free(chunks);
+  return result;
+}
+
+MINESWEEPER_RESULT minesweeper_analysis_write_board(
+    FILE *file, minesweeper_coordinate width, minesweeper_coordinate height,
+    uint16_t mine_count, const MINESWEEPER_POINT *mines) {
+  if ((NULL == file) || ((NULL == mines) && (mine_count > 0u))) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+
+  bool ok = fprintf(file, "%u %u %u", width, height, mine_count) > 0;
+  for (uint32_t i = 0; (i < mine_count) && ok; i++) {
+    ok = fprintf(file, " %u %u", mines[i].x, mines[i].y) > 0;
+  }
+  ok = ok && (fputc('\n', file) != EOF);
+
+  return ok ? MINESWEEPER_RESULT_SUCCESS : MINESWEEPER_RESULT_UNKNOWN_ERR;
+}
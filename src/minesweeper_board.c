@@ -0,0 +1,500 @@
+#include "minesweeper_board.h"
+#include <ctype.h>
+#include <stddef.h>
+
+/*
+ * The engine is written once as a set of always inlined functions taking the
+ * board size as parameters. Each preset then gets its own copy with the size
+ * passed as constants, so the bounds checks fold away and the loops unroll,
+ * while the generic engine passes the size stored in the board.
+ */
+#if defined(__GNUC__)
+#define MINESWEEPER_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define MINESWEEPER_ALWAYS_INLINE inline
+#endif
+
+/**
+ * @brief Checks if the given point is on the board.
+ *
+ * @param point     [in]    The point to check.
+ * @param width     [in]    Number of columns.
+ * @param height    [in]    Number of rows.
+ * @return true     The point is valid.
+ * @return false    The point is invalid.
+ */
+static MINESWEEPER_ALWAYS_INLINE bool
+board_check_point(const MINESWEEPER_POINT *point, uint32_t width,
+                  uint32_t height) {
+  return (point->x < width) && (point->y < height);
+}
+
+/**
+ * @brief Changes the specified hidden or flagged point to its revealed
+ * equivalent.
+ *
+ * @param board [in/out]    The board containing the state of all points.
+ * @param index [in]        Index of the point to show in the grid.
+ */
+static MINESWEEPER_ALWAYS_INLINE void board_show_point(MINESWEEPER_BOARD *board,
+                                                       uint32_t index) {
+  switch (board->grid[index]) {
+  case MINESWEEPER_STATE_MINE_HIDDEN:
+  /* Fallthrough, flagging has no effect on the underlying state */
+  case MINESWEEPER_STATE_MINE_FLAGGED:
+    board->grid[index] = MINESWEEPER_STATE_MINE_SHOWN;
+    break;
+  case MINESWEEPER_STATE_CLEAR_HIDDEN:
+  /* Fallthrough, flagging has no effect on the underlying state */
+  case MINESWEEPER_STATE_CLEAR_FLAGGED:
+    board->grid[index] = MINESWEEPER_STATE_CLEAR_SHOWN;
+    board->shown_points++;
+    break;
+  case MINESWEEPER_STATE_MINE_SHOWN:
+  case MINESWEEPER_STATE_CLEAR_SHOWN:
+  default:
+    /* Nothing to do, already shown */
+    break;
+  }
+}
+
+/**
+ * @brief Changes every hidden or flagged point to its revealed equivalent.
+ *
+ * Written without branches so the loop can be vectorised.
+ *
+ * @param board [in/out]    The board containing the state of all points.
+ * @param size  [in]        Number of points on the board.
+ */
+static MINESWEEPER_ALWAYS_INLINE void board_show_all(MINESWEEPER_BOARD *board,
+                                                     uint32_t size) {
+  MINESWEEPER_STATE *grid = board->grid;
+  uint32_t shown = 0;
+
+  for (uint32_t i = 0; i < size; i++) {
+    MINESWEEPER_STATE state = grid[i];
+    bool is_clear = (MINESWEEPER_STATE_CLEAR_HIDDEN == state) ||
+                    (MINESWEEPER_STATE_CLEAR_FLAGGED == state);
+    bool is_mine = (MINESWEEPER_STATE_MINE_HIDDEN == state) ||
+                   (MINESWEEPER_STATE_MINE_FLAGGED == state);
+    state = is_mine ? MINESWEEPER_STATE_MINE_SHOWN : state;
+    grid[i] = is_clear ? MINESWEEPER_STATE_CLEAR_SHOWN : state;
+    shown += is_clear;
+  }
+  board->shown_points = (uint16_t)(board->shown_points + shown);
+}
+
+static MINESWEEPER_ALWAYS_INLINE MINESWEEPER_RESULT
+board_reset(MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *mines,
+            uint32_t width, uint32_t height, uint32_t mine_count) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+  board->is_init = false;
+  board->shown_points = 0;
+
+  /* Initialise the grid to its default initial value, clear and hidden */
+  for (uint32_t i = 0; i < (width * height); i++) {
+    board->grid[i] = MINESWEEPER_STATE_CLEAR_HIDDEN;
+  }
+  /* Now try to populate the given mines */
+  for (uint32_t i = 0; i < mine_count; i++) {
+    if (!board_check_point(&mines[i], width, height)) {
+      result = MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+      break;
+    }
+    uint32_t index = (mines[i].x * height) + mines[i].y;
+    if (board->grid[index] == MINESWEEPER_STATE_MINE_HIDDEN) {
+      /* Duplicate mine */
+      result = MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+      break;
+    }
+    board->grid[index] = MINESWEEPER_STATE_MINE_HIDDEN;
+  }
+
+  if (MINESWEEPER_RESULT_SUCCESS == result) {
+    board->is_init = true;
+  }
+
+  return result;
+}
+
+static MINESWEEPER_ALWAYS_INLINE MINESWEEPER_RESULT
+board_pick(MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *point,
+           uint32_t width, uint32_t height, uint32_t mine_count) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+
+  if (!board->is_init) {
+    return MINESWEEPER_RESULT_NOT_INIT;
+  }
+  if (!board_check_point(point, width, height)) {
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+
+  switch (board->grid[(point->x * height) + point->y]) {
+  case MINESWEEPER_STATE_MINE_HIDDEN:
+    /* Fallthrough, flagging has no effect on the underlying state */
+  case MINESWEEPER_STATE_MINE_FLAGGED:
+    /* Lost, show everything */
+    board_show_all(board, width * height);
+    result = MINESWEEPER_RESULT_LOSE;
+    break;
+  case MINESWEEPER_STATE_CLEAR_HIDDEN:
+    /* Fallthrough, flagging has no effect on the underlying state */
+  case MINESWEEPER_STATE_CLEAR_FLAGGED:
+    /* Show the point, and the 8 adjacent squares */
+    for (int i = -1; i <= 1; i++) {
+      uint32_t x = (minesweeper_coordinate)(point->x + i);
+      if (x < width) {
+        for (int j = -1; j <= 1; j++) {
+          uint32_t y = (minesweeper_coordinate)(point->y + j);
+          if (y < height) {
+            board_show_point(board, (x * height) + y);
+          }
+        }
+      }
+    }
+    /* If all non-mine points are now visible, the player has won */
+    if (board->shown_points == ((width * height) - mine_count)) {
+      result = MINESWEEPER_RESULT_WIN;
+    }
+    break;
+  case MINESWEEPER_STATE_MINE_SHOWN:
+  case MINESWEEPER_STATE_CLEAR_SHOWN:
+  default:
+    /* Already visible */
+    result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+    break;
+  }
+
+  return result;
+}
+
+static MINESWEEPER_ALWAYS_INLINE MINESWEEPER_RESULT
+board_flag(MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *point,
+           uint32_t width, uint32_t height) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+
+  if (!board->is_init) {
+    return MINESWEEPER_RESULT_NOT_INIT;
+  }
+  if (!board_check_point(point, width, height)) {
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+
+  MINESWEEPER_STATE *state = &board->grid[(point->x * height) + point->y];
+  switch (*state) {
+  case MINESWEEPER_STATE_MINE_HIDDEN:
+    *state = MINESWEEPER_STATE_MINE_FLAGGED;
+    break;
+  case MINESWEEPER_STATE_CLEAR_HIDDEN:
+    *state = MINESWEEPER_STATE_CLEAR_FLAGGED;
+    break;
+  case MINESWEEPER_STATE_MINE_SHOWN:
+  case MINESWEEPER_STATE_CLEAR_SHOWN:
+  case MINESWEEPER_STATE_MINE_FLAGGED:
+  case MINESWEEPER_STATE_CLEAR_FLAGGED:
+  default:
+    /* Already visible or already flagged */
+    result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+    break;
+  }
+
+  return result;
+}
+
+/* The generic engine, sized from the board at runtime */
+static MINESWEEPER_RESULT generic_reset(MINESWEEPER_BOARD *board,
+                                        const MINESWEEPER_POINT *mines) {
+  return board_reset(board, mines, board->width, board->height,
+                     board->mine_count);
+}
+
+static MINESWEEPER_RESULT generic_pick(MINESWEEPER_BOARD *board,
+                                       const MINESWEEPER_POINT *point) {
+  return board_pick(board, point, board->width, board->height,
+                    board->mine_count);
+}
+
+static MINESWEEPER_RESULT generic_flag(MINESWEEPER_BOARD *board,
+                                       const MINESWEEPER_POINT *point) {
+  return board_flag(board, point, board->width, board->height);
+}
+
+/* One engine per preset, sized at compile time */
+#define MINESWEEPER_PRESET_ENGINE(name, width, height, mines)                  \
+  static MINESWEEPER_RESULT preset_##name##_reset(                             \
+      MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *m) {                  \
+    return board_reset(board, m, (width), (height), (mines));                  \
+  }                                                                            \
+  static MINESWEEPER_RESULT preset_##name##_pick(                              \
+      MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *point) {              \
+    return board_pick(board, point, (width), (height), (mines));               \
+  }                                                                            \
+  static MINESWEEPER_RESULT preset_##name##_flag(                              \
+      MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *point) {              \
+    return board_flag(board, point, (width), (height));                        \
+  }
+
+MINESWEEPER_PRESETS(MINESWEEPER_PRESET_ENGINE)
+
+#undef MINESWEEPER_PRESET_ENGINE
+
+MINESWEEPER_PRESET minesweeper_preset_find(minesweeper_coordinate width,
+                                           minesweeper_coordinate height,
+                                           uint16_t mine_count) {
+#define MINESWEEPER_PRESET_MATCH(name, w, h, mines)                            \
+  if ((width == (w)) && (height == (h)) && (mine_count == (mines))) {          \
+    return MINESWEEPER_PRESET_##name;                                          \
+  }
+  MINESWEEPER_PRESETS(MINESWEEPER_PRESET_MATCH)
+#undef MINESWEEPER_PRESET_MATCH
+
+  return MINESWEEPER_PRESET_CUSTOM;
+}
+
+MINESWEEPER_RESULT minesweeper_preset_size(MINESWEEPER_PRESET preset,
+                                           minesweeper_coordinate *width,
+                                           minesweeper_coordinate *height,
+                                           uint16_t *mine_count) {
+  if ((NULL == width) || (NULL == height) || (NULL == mine_count)) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+
+  switch (preset) {
+#define MINESWEEPER_PRESET_SIZE(name, w, h, mines)                             \
+  case MINESWEEPER_PRESET_##name:                                              \
+    *width = (w);                                                              \
+    *height = (h);                                                             \
+    *mine_count = (mines);                                                     \
+    return MINESWEEPER_RESULT_SUCCESS;
+    MINESWEEPER_PRESETS(MINESWEEPER_PRESET_SIZE)
+#undef MINESWEEPER_PRESET_SIZE
+  case MINESWEEPER_PRESET_CUSTOM:
+  default:
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+}
+
+/* Indexed by MINESWEEPER_PRESET */
+static const char *const preset_names[] = {
+#define MINESWEEPER_PRESET_NAME(name, width, height, mines) #name,
+    MINESWEEPER_PRESETS(MINESWEEPER_PRESET_NAME)
+#undef MINESWEEPER_PRESET_NAME
+        "CUSTOM",
+};
+
+MINESWEEPER_PRESET minesweeper_preset_from_name(const char *name) {
+  if (NULL == name) {
+    return MINESWEEPER_PRESET_CUSTOM;
+  }
+
+  for (uint32_t p = 0; p < (uint32_t)MINESWEEPER_PRESET_CUSTOM; p++) {
+    const char *expected = preset_names[p];
+    const char *actual = name;
+    while (('\0' != *expected) &&
+           (toupper((unsigned char)*actual) == *expected)) {
+      expected++;
+      actual++;
+    }
+    if (('\0' == *expected) && ('\0' == *actual)) {
+      return (MINESWEEPER_PRESET)p;
+    }
+  }
+
+  return MINESWEEPER_PRESET_CUSTOM;
+}
+
+const char *minesweeper_preset_name(MINESWEEPER_PRESET preset) {
+  if ((uint32_t)preset > (uint32_t)MINESWEEPER_PRESET_CUSTOM) {
+    preset = MINESWEEPER_PRESET_CUSTOM;
+  }
+  return preset_names[preset];
+}
+
+MINESWEEPER_RESULT minesweeper_board_init(MINESWEEPER_BOARD *board,
+                                          MINESWEEPER_STATE *grid,
+                                          minesweeper_coordinate width,
+                                          minesweeper_coordinate height,
+                                          uint16_t mine_count) {
+  if ((NULL == board) || (NULL == grid)) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  /* There must be at least one clear point to pick */
+  if ((0u == width) || (0u == height) ||
+      (mine_count >= ((uint32_t)width * height))) {
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+
+  board->grid = grid;
+  board->width = width;
+  board->height = height;
+  board->mine_count = mine_count;
+  board->shown_points = 0;
+  board->is_init = false;
+  board->preset = minesweeper_preset_find(width, height, mine_count);
+  board->events = NULL;
+  board->game_id = 0;
+
+  return MINESWEEPER_RESULT_SUCCESS;
+}
+
+MINESWEEPER_RESULT minesweeper_board_init_preset(MINESWEEPER_BOARD *board,
+                                                 MINESWEEPER_STATE *grid,
+                                                 MINESWEEPER_PRESET preset) {
+  minesweeper_coordinate width;
+  minesweeper_coordinate height;
+  uint16_t mine_count;
+  MINESWEEPER_RESULT result =
+      minesweeper_preset_size(preset, &width, &height, &mine_count);
+
+  if (MINESWEEPER_RESULT_SUCCESS != result) {
+    return result;
+  }
+  return minesweeper_board_init(board, grid, width, height, mine_count);
+}
+
+/*
+ * Dispatches to the preset engine for the board, or the generic one. The
+ * preset field is public, so it's only trusted when the board really is that
+ * size, otherwise a preset engine would run off the end of a smaller grid.
+ */
+#define MINESWEEPER_PRESET_FITS(w, h, count)                                   \
+  ((board->width == (w)) && (board->height == (h)) &&                          \
+   (board->mine_count == (count)))
+#define MINESWEEPER_PRESET_DISPATCH_RESET(name, w, h, count)                   \
+  case MINESWEEPER_PRESET_##name:                                              \
+    if (MINESWEEPER_PRESET_FITS(w, h, count)) {                                \
+      return preset_##name##_reset(board, mines);                              \
+    }                                                                          \
+    break;
+#define MINESWEEPER_PRESET_DISPATCH_PICK(name, w, h, count)                    \
+  case MINESWEEPER_PRESET_##name:                                              \
+    if (MINESWEEPER_PRESET_FITS(w, h, count)) {                                \
+      return preset_##name##_pick(board, point);                               \
+    }                                                                          \
+    break;
+#define MINESWEEPER_PRESET_DISPATCH_FLAG(name, w, h, count)                    \
+  case MINESWEEPER_PRESET_##name:                                              \
+    if (MINESWEEPER_PRESET_FITS(w, h, count)) {                                \
+      return preset_##name##_flag(board, point);                               \
+    }                                                                          \
+    break;
+
+static inline MINESWEEPER_RESULT
+board_dispatch_reset(MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *mines) {
+  switch (board->preset) {
+    MINESWEEPER_PRESETS(MINESWEEPER_PRESET_DISPATCH_RESET)
+  case MINESWEEPER_PRESET_CUSTOM:
+  default:
+    break;
+  }
+  return generic_reset(board, mines);
+}
+
+static inline MINESWEEPER_RESULT
+board_dispatch_pick(MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *point) {
+  switch (board->preset) {
+    MINESWEEPER_PRESETS(MINESWEEPER_PRESET_DISPATCH_PICK)
+  case MINESWEEPER_PRESET_CUSTOM:
+  default:
+    break;
+  }
+  return generic_pick(board, point);
+}
+
+static inline MINESWEEPER_RESULT
+board_dispatch_flag(MINESWEEPER_BOARD *board, const MINESWEEPER_POINT *point) {
+  switch (board->preset) {
+    MINESWEEPER_PRESETS(MINESWEEPER_PRESET_DISPATCH_FLAG)
+  case MINESWEEPER_PRESET_CUSTOM:
+  default:
+    break;
+  }
+  return generic_flag(board, point);
+}
+
+#undef MINESWEEPER_PRESET_DISPATCH_RESET
+#undef MINESWEEPER_PRESET_DISPATCH_PICK
+#undef MINESWEEPER_PRESET_DISPATCH_FLAG
+#undef MINESWEEPER_PRESET_FITS
+
+/**
+ * @brief Queues an event for the board's event log.
+ *
+ * @param board     [in]    The board the event happened on.
+ * @param type      [in]    The kind of event.
+ * @param x         [in]    X coordinate for the event.
+ * @param y         [in]    Y coordinate for the event.
+ * @param result    [in]    Result of the move.
+ * @param revealed  [in]    Number of clear points revealed.
+ */
+static void board_log(const MINESWEEPER_BOARD *board,
+                      MINESWEEPER_EVENT_TYPE type, minesweeper_coordinate x,
+                      minesweeper_coordinate y, MINESWEEPER_RESULT result,
+                      uint16_t revealed) {
+  MINESWEEPER_EVENT event = {0, board->game_id, revealed, (uint8_t)type,
+                             x,  y,              (uint8_t)result};
+  minesweeper_events_push(board->events, &event);
+}
+
+/**
+ * @brief Logs the end of the game, if the move finished it.
+ *
+ * @param board         [in]    The board the move was made on.
+ * @param point         [in]    The point of the final move.
+ * @param result        [in]    Result of the move.
+ * @param shown_before  [in]    Clear points shown before the final move.
+ */
+static void board_log_end(const MINESWEEPER_BOARD *board,
+                          const MINESWEEPER_POINT *point,
+                          MINESWEEPER_RESULT result, uint16_t shown_before) {
+  if (MINESWEEPER_RESULT_WIN == result) {
+    board_log(board, MINESWEEPER_EVENT_GAME_END, point->x, point->y, result,
+              board->shown_points);
+  } else if (MINESWEEPER_RESULT_LOSE == result) {
+    /* How far the player got, not the board shown after losing */
+    board_log(board, MINESWEEPER_EVENT_GAME_END, point->x, point->y, result,
+              shown_before);
+  }
+}
+
+MINESWEEPER_RESULT minesweeper_board_reset(MINESWEEPER_BOARD *board,
+                                           const MINESWEEPER_POINT *mines) {
+  MINESWEEPER_RESULT result = board_dispatch_reset(board, mines);
+
+  if (NULL != board->events) {
+    board->game_id = minesweeper_events_game_id(board->events);
+    board_log(board, MINESWEEPER_EVENT_GAME_START, board->width, board->height,
+              result, 0);
+  }
+
+  return result;
+}
+
+MINESWEEPER_RESULT minesweeper_board_pick(MINESWEEPER_BOARD *board,
+                                          const MINESWEEPER_POINT *point) {
+  uint16_t shown_before = board->shown_points;
+  MINESWEEPER_RESULT result = board_dispatch_pick(board, point);
+
+  if (NULL != board->events) {
+    /* A losing pick reveals the whole board, which isn't the pick's doing */
+    uint16_t revealed = (MINESWEEPER_RESULT_LOSE == result)
+                            ? 0u
+                            : (uint16_t)(board->shown_points - shown_before);
+    board_log(board, MINESWEEPER_EVENT_PICK, point->x, point->y, result,
+              revealed);
+    board_log_end(board, point, result, shown_before);
+  }
+
+  return result;
+}
+
+MINESWEEPER_RESULT minesweeper_board_flag(MINESWEEPER_BOARD *board,
+                                          const MINESWEEPER_POINT *point) {
+  MINESWEEPER_RESULT result = board_dispatch_flag(board, point);
+
+  if (NULL != board->events) {
+    board_log(board, MINESWEEPER_EVENT_FLAG, point->x, point->y, result, 0);
+  }
+
+  return result;
+}
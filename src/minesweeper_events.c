@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_events.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Keeps the producer and flusher counters on separate cache lines */
+#define EVENTS_CACHE_LINE (64u)
+/* Number of records batched into a single frame */
+#define EVENTS_FRAME_RECORDS (4096u)
+/* Size of the frame length prefix */
+#define EVENTS_FRAME_HEADER (4u)
+/* How long the flusher sleeps when there is nothing to write */
+#define EVENTS_IDLE_NS (1000000L)
+/* Game IDs are the ring number followed by a count of games on that ring */
+#define EVENTS_GAME_ID_SHIFT (40u)
+
+struct MINESWEEPER_EVENT_RING {
+  /** Next event to write, only written by the producer */
+  _Alignas(EVENTS_CACHE_LINE) atomic_uint_fast64_t head;
+  /** Next event to flush, only written by the flusher */
+  _Alignas(EVENTS_CACHE_LINE) atomic_uint_fast64_t tail;
+  /** Events lost to a full ring */
+  _Alignas(EVENTS_CACHE_LINE) atomic_uint_fast64_t dropped;
+  atomic_bool released;         /*! Free once flushed, the producer is done */
+  uint64_t games;               /*! Games started on this ring */
+  uint64_t id;                  /*! Ring number within the sink */
+  uint32_t mask;                /*! Capacity - 1 */
+  MINESWEEPER_EVENT *events;    /*! The queued events */
+  MINESWEEPER_EVENT_RING *next; /*! Next ring in the sink */
+};
+
+struct MINESWEEPER_EVENT_SINK {
+  FILE *file;                   /*! The event log */
+  uint32_t capacity;            /*! Events per ring */
+  pthread_mutex_t lock;         /*! Guards the ring list */
+  pthread_cond_t wake;          /*! Wakes the flusher to stop */
+  pthread_t flusher;            /*! Background flusher thread */
+  atomic_bool stop;             /*! Tells the flusher to finish */
+  bool write_failed;            /*! Set if any frame failed to write */
+  uint64_t ring_count;          /*! Number of rings created */
+  uint64_t released_dropped;    /*! Events dropped by rings since freed */
+  MINESWEEPER_EVENT_RING *rings; /*! All rings feeding the sink */
+  uint32_t frame_length;        /*! Bytes of records in the frame buffer */
+  uint8_t frame[EVENTS_FRAME_HEADER +
+                (EVENTS_FRAME_RECORDS * MINESWEEPER_EVENT_RECORD_SIZE)];
+};
+
+/**
+ * @brief Writes a little endian value into a buffer.
+ *
+ * @param buffer    [out]   Where to write the value.
+ * @param value     [in]    The value to write.
+ * @param bytes     [in]    Number of bytes to write.
+ */
+static void put_le(uint8_t *buffer, uint64_t value, uint32_t bytes) {
+  for (uint32_t i = 0; i < bytes; i++) {
+    buffer[i] = (uint8_t)(value >> (8u * i));
+  }
+}
+
+/**
+ * @brief Writes the records in the frame buffer out to the file as a frame.
+ *
+ * @param sink  [in/out]    The sink to write.
+ */
+static void events_write_frame(MINESWEEPER_EVENT_SINK *sink) {
+  if (0u == sink->frame_length) {
+    return;
+  }
+  put_le(sink->frame, sink->frame_length, EVENTS_FRAME_HEADER);
+  size_t size = EVENTS_FRAME_HEADER + sink->frame_length;
+  if (fwrite(sink->frame, 1, size, sink->file) != size) {
+    sink->write_failed = true;
+  }
+  sink->frame_length = 0;
+}
+
+/**
+ * @brief Moves every queued event from the rings into frames, and frees any
+ * released rings once they're empty.
+ *
+ * @param sink  [in/out]    The sink to flush.
+ * @return uint64_t The number of events flushed.
+ */
+static uint64_t events_flush(MINESWEEPER_EVENT_SINK *sink) {
+  uint64_t flushed = 0;
+  MINESWEEPER_EVENT_RING **link = &sink->rings;
+
+  pthread_mutex_lock(&sink->lock);
+  while (NULL != *link) {
+    MINESWEEPER_EVENT_RING *ring = *link;
+    /* Checked before reading head, so a released ring's last events are seen */
+    bool released =
+        atomic_load_explicit(&ring->released, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    for (; tail != head; tail++) {
+      const MINESWEEPER_EVENT *event = &ring->events[tail & ring->mask];
+      uint8_t *record =
+          &sink->frame[EVENTS_FRAME_HEADER + sink->frame_length];
+      put_le(&record[0], event->timestamp, 8);
+      put_le(&record[8], event->game_id, 8);
+      put_le(&record[16], event->revealed, 2);
+      record[18] = event->type;
+      record[19] = event->x;
+      record[20] = event->y;
+      record[21] = event->result;
+      put_le(&record[22], 0, 2);
+      sink->frame_length += MINESWEEPER_EVENT_RECORD_SIZE;
+
+      if (sink->frame_length ==
+          (EVENTS_FRAME_RECORDS * MINESWEEPER_EVENT_RECORD_SIZE)) {
+        events_write_frame(sink);
+      }
+      /* Hand the slot back to the producer as soon as it's been copied */
+      atomic_store_explicit(&ring->tail, tail + 1u, memory_order_release);
+      flushed++;
+    }
+
+    if (released) {
+      *link = ring->next;
+      sink->released_dropped +=
+          atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+      free(ring->events);
+      free(ring);
+    } else {
+      link = &ring->next;
+    }
+  }
+  events_write_frame(sink);
+  pthread_mutex_unlock(&sink->lock);
+
+  if (flushed > 0u) {
+    fflush(sink->file);
+  }
+  return flushed;
+}
+
+/**
+ * @brief Background thread which flushes events until told to stop.
+ *
+ * @param arg   [in/out]    The MINESWEEPER_EVENT_SINK to flush.
+ * @return void* Always NULL.
+ */
+static void *events_flusher(void *arg) {
+  MINESWEEPER_EVENT_SINK *sink = arg;
+
+  while (!atomic_load(&sink->stop)) {
+    if (0u == events_flush(sink)) {
+      /* Nothing to do, sleep until there might be */
+      struct timespec until;
+      clock_gettime(CLOCK_REALTIME, &until);
+      until.tv_nsec += EVENTS_IDLE_NS;
+      if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+      }
+      pthread_mutex_lock(&sink->lock);
+      if (!atomic_load(&sink->stop)) {
+        pthread_cond_timedwait(&sink->wake, &sink->lock, &until);
+      }
+      pthread_mutex_unlock(&sink->lock);
+    }
+  }
+
+  /* Anything queued before the stop still gets written */
+  events_flush(sink);
+  return NULL;
+}
+
+MINESWEEPER_EVENT_SINK *minesweeper_events_open(const char *path,
+                                                uint32_t capacity) {
+  if ((NULL == path) || (0u == capacity) || (capacity > (UINT32_MAX / 2u))) {
+    return NULL;
+  }
+
+  MINESWEEPER_EVENT_SINK *sink = calloc(1, sizeof(*sink));
+  if (NULL == sink) {
+    return NULL;
+  }
+  sink->capacity = 1u;
+  while (sink->capacity < capacity) {
+    sink->capacity <<= 1;
+  }
+  atomic_init(&sink->stop, false);
+  sink->file = fopen(path, "wb");
+  if (NULL == sink->file) {
+    free(sink);
+    return NULL;
+  }
+  pthread_mutex_init(&sink->lock, NULL);
+  pthread_cond_init(&sink->wake, NULL);
+  if (0 != pthread_create(&sink->flusher, NULL, events_flusher, sink)) {
+    pthread_cond_destroy(&sink->wake);
+    pthread_mutex_destroy(&sink->lock);
+    fclose(sink->file);
+    free(sink);
+    return NULL;
+  }
+
+  return sink;
+}
+
+MINESWEEPER_EVENT_RING *minesweeper_events_ring(MINESWEEPER_EVENT_SINK *sink) {
+  if (NULL == sink) {
+    return NULL;
+  }
+
+  /* aligned_alloc needs the size to be a multiple of the alignment */
+  size_t size = ((sizeof(MINESWEEPER_EVENT_RING) + EVENTS_CACHE_LINE - 1u) /
+                 EVENTS_CACHE_LINE) *
+                EVENTS_CACHE_LINE;
+  MINESWEEPER_EVENT_RING *ring = aligned_alloc(EVENTS_CACHE_LINE, size);
+  if (NULL == ring) {
+    return NULL;
+  }
+  memset(ring, 0, size);
+  ring->events = malloc(sink->capacity * sizeof(*ring->events));
+  if (NULL == ring->events) {
+    free(ring);
+    return NULL;
+  }
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->dropped, 0);
+  atomic_init(&ring->released, false);
+  ring->mask = sink->capacity - 1u;
+
+  pthread_mutex_lock(&sink->lock);
+  ring->id = sink->ring_count++;
+  ring->next = sink->rings;
+  sink->rings = ring;
+  pthread_mutex_unlock(&sink->lock);
+
+  return ring;
+}
+
+void minesweeper_events_ring_release(MINESWEEPER_EVENT_RING *ring) {
+  if (NULL != ring) {
+    atomic_store_explicit(&ring->released, true, memory_order_release);
+  }
+}
+
+uint64_t minesweeper_events_game_id(MINESWEEPER_EVENT_RING *ring) {
+  return (ring->id << EVENTS_GAME_ID_SHIFT) | ring->games++;
+}
+
+bool minesweeper_events_push(MINESWEEPER_EVENT_RING *ring,
+                             MINESWEEPER_EVENT *event) {
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+  if ((head - tail) > ring->mask) {
+    atomic_fetch_add_explicit(&ring->dropped, 1u, memory_order_relaxed);
+    return false;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  event->timestamp =
+      ((uint64_t)now.tv_sec * 1000000000u) + (uint64_t)now.tv_nsec;
+  ring->events[head & ring->mask] = *event;
+  atomic_store_explicit(&ring->head, head + 1u, memory_order_release);
+
+  return true;
+}
+
+uint64_t minesweeper_events_dropped(MINESWEEPER_EVENT_SINK *sink) {
+  pthread_mutex_lock(&sink->lock);
+  uint64_t dropped = sink->released_dropped;
+  for (MINESWEEPER_EVENT_RING *ring = sink->rings; NULL != ring;
+       ring = ring->next) {
+    dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&sink->lock);
+
+  return dropped;
+}
+
+MINESWEEPER_RESULT minesweeper_events_close(MINESWEEPER_EVENT_SINK *sink) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+
+  if (NULL == sink) {
+    return MINESWEEPER_RESULT_NOT_INIT;
+  }
+
+  pthread_mutex_lock(&sink->lock);
+  atomic_store(&sink->stop, true);
+  pthread_cond_signal(&sink->wake);
+  pthread_mutex_unlock(&sink->lock);
+  pthread_join(sink->flusher, NULL);
+
+  if ((0 != fclose(sink->file)) || sink->write_failed) {
+    result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  while (NULL != sink->rings) {
+    MINESWEEPER_EVENT_RING *ring = sink->rings;
+    sink->rings = ring->next;
+    free(ring->events);
+    free(ring);
+  }
+  pthread_cond_destroy(&sink->wake);
+  pthread_mutex_destroy(&sink->lock);
+  free(sink);
+
+  return result;
+}
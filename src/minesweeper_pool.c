@@ -0,0 +1,474 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_pool.h"
+#include "minesweeper_random.h"
+#include "minesweeper_threads.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Keeps counters written by different threads on separate cache lines */
+#define POOL_CACHE_LINE (64u)
+/* Rejected boards in a row before a refill thread starts backing off */
+#define POOL_REJECT_RUN (1024u)
+/* Shortest and longest a refill thread backs off for */
+#define POOL_BACKOFF_MIN_NS (1000000L)
+#define POOL_BACKOFF_MAX_NS (128000000L)
+
+/**
+ * @brief A slot in a queue. The sequence says whether the slot is ready to be
+ * written or read for a given position.
+ *
+ */
+typedef struct {
+  atomic_size_t sequence;       /*! Position the slot is ready for */
+  MINESWEEPER_POOL_BOARD board; /*! The board in the slot */
+} POOL_CELL;
+
+/**
+ * @brief A bounded multi-producer multi-consumer queue of ready boards.
+ *
+ */
+typedef struct {
+  /** Next position to write */
+  _Alignas(POOL_CACHE_LINE) atomic_size_t enqueue;
+  /** Next position to read */
+  _Alignas(POOL_CACHE_LINE) atomic_size_t dequeue;
+  /** Counters updated by the refill threads */
+  _Alignas(POOL_CACHE_LINE) atomic_uint_fast64_t generated;
+  atomic_uint_fast64_t rejected;
+  atomic_uint_fast64_t busy_ns; /*! Time spent generating, rejects included */
+  /** Counters updated by the callers */
+  _Alignas(POOL_CACHE_LINE) atomic_uint_fast64_t popped;
+  atomic_uint_fast64_t empty;
+  POOL_CELL *cells;  /*! capacity cells */
+  size_t mask;       /*! capacity - 1 */
+  uint32_t low_water; /*! Sleeping refill threads are woken below this depth */
+} POOL_QUEUE;
+
+/**
+ * @brief Everything a single refill thread needs.
+ *
+ */
+typedef struct {
+  MINESWEEPER_POOL *pool; /*! The pool to refill */
+  uint32_t stream;        /*! Generator stream for this thread */
+  pthread_t id;           /*! The thread */
+  bool started;           /*! Whether the thread is running */
+} POOL_WORKER;
+
+struct MINESWEEPER_POOL {
+  POOL_QUEUE queues[MINESWEEPER_POOL_PRESETS]; /*! One queue per preset */
+  MINESWEEPER_POOL_CONFIG config;              /*! How to fill the pool */
+  atomic_bool stop;            /*! Tells the refill threads to finish */
+  pthread_mutex_t lock;        /*! Guards sleeping on refill */
+  pthread_cond_t refill;       /*! Wakes the refill threads */
+  atomic_uint sleepers;        /*! Refill threads waiting on refill */
+  atomic_uint_fast64_t next_id; /*! ID for the next generated board */
+  uint32_t worker_count;       /*! Number of refill threads */
+  POOL_WORKER *workers;        /*! The refill threads */
+};
+
+/**
+ * @brief Adds a board to a queue.
+ *
+ * @param queue [in/out]    The queue.
+ * @param board [in]        The board to add.
+ * @return true     The board was added.
+ * @return false    The queue was full.
+ */
+static bool pool_push(POOL_QUEUE *queue, const MINESWEEPER_POOL_BOARD *board) {
+  size_t position = atomic_load_explicit(&queue->enqueue, memory_order_relaxed);
+  POOL_CELL *cell;
+
+  for (;;) {
+    cell = &queue->cells[position & queue->mask];
+    size_t sequence =
+        atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+    if (0 == diff) {
+      if (atomic_compare_exchange_weak_explicit(
+              &queue->enqueue, &position, position + 1u, memory_order_relaxed,
+              memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      position = atomic_load_explicit(&queue->enqueue, memory_order_relaxed);
+    }
+  }
+
+  cell->board = *board;
+  atomic_store_explicit(&cell->sequence, position + 1u, memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Takes a board from a queue.
+ *
+ * @param queue [in/out]    The queue.
+ * @param board [out]       The board taken.
+ * @return true     A board was taken.
+ * @return false    The queue was empty.
+ */
+static bool pool_take(POOL_QUEUE *queue, MINESWEEPER_POOL_BOARD *board) {
+  size_t position = atomic_load_explicit(&queue->dequeue, memory_order_relaxed);
+  POOL_CELL *cell;
+
+  for (;;) {
+    cell = &queue->cells[position & queue->mask];
+    size_t sequence =
+        atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)(position + 1u);
+    if (0 == diff) {
+      if (atomic_compare_exchange_weak_explicit(
+              &queue->dequeue, &position, position + 1u, memory_order_relaxed,
+              memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      position = atomic_load_explicit(&queue->dequeue, memory_order_relaxed);
+    }
+  }
+
+  *board = cell->board;
+  /* Hand the slot back for the write one lap later */
+  atomic_store_explicit(&cell->sequence, position + queue->mask + 1u,
+                        memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Gets the number of boards in a queue.
+ *
+ * @param queue [in]    The queue.
+ * @return uint32_t The number of boards, which may be slightly out of date.
+ */
+static uint32_t pool_depth(POOL_QUEUE *queue) {
+  size_t dequeue = atomic_load_explicit(&queue->dequeue, memory_order_relaxed);
+  size_t enqueue = atomic_load_explicit(&queue->enqueue, memory_order_relaxed);
+  return (enqueue > dequeue) ? (uint32_t)(enqueue - dequeue) : 0u;
+}
+
+/**
+ * @brief Generates a board for a preset.
+ *
+ * @param pool      [in/out]    The pool the board is for.
+ * @param preset    [in]        The preset to generate for.
+ * @param rng       [in/out]    The generator for the calling thread.
+ * @param board     [out]       The generated board.
+ * @return true     The board is within the pool's limits.
+ * @return false    The board should be thrown away.
+ */
+static bool pool_generate(MINESWEEPER_POOL *pool, MINESWEEPER_PRESET preset,
+                          MINESWEEPER_RANDOM *rng,
+                          MINESWEEPER_POOL_BOARD *board) {
+  minesweeper_coordinate width;
+  minesweeper_coordinate height;
+  uint16_t mine_count;
+
+  if (MINESWEEPER_RESULT_SUCCESS !=
+      minesweeper_preset_size(preset, &width, &height, &mine_count)) {
+    return false;
+  }
+
+  minesweeper_random_mines(rng, width, height, mine_count, board->mines);
+  if (MINESWEEPER_RESULT_SUCCESS !=
+      minesweeper_analyze(width, height, mine_count, board->mines,
+                          board->adjacent, &board->analysis)) {
+    return false;
+  }
+
+  uint32_t min_bbbv = pool->config.min_bbbv[preset];
+  uint32_t max_bbbv = pool->config.max_bbbv[preset];
+  if ((board->analysis.bbbv < min_bbbv) ||
+      ((0u != max_bbbv) && (board->analysis.bbbv > max_bbbv))) {
+    return false;
+  }
+
+  board->preset = preset;
+  board->id = atomic_fetch_add_explicit(&pool->next_id, 1u,
+                                        memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return uint64_t The time in nanoseconds.
+ */
+static uint64_t pool_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * 1000000000u) + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Checks whether any queue has dropped below its low water mark.
+ *
+ * @param pool  [in]    The pool.
+ * @return true     A queue needs refilling.
+ * @return false    Every queue is at or above its low water mark.
+ */
+static bool pool_wanted(MINESWEEPER_POOL *pool) {
+  for (uint32_t p = 0; p < MINESWEEPER_POOL_PRESETS; p++) {
+    if (pool_depth(&pool->queues[p]) < pool->queues[p].low_water) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Puts a refill thread to sleep until a queue runs low, the pool is
+ * stopped, or the timeout passes.
+ *
+ * @param pool          [in/out]    The pool.
+ * @param timeout_ns    [in]        How long to back off for, or 0 to sleep
+ * until a queue drops below its low water mark.
+ */
+static void pool_sleep(MINESWEEPER_POOL *pool, long timeout_ns) {
+  pthread_mutex_lock(&pool->lock);
+  /* Pairs with the fence in minesweeper_pool_pop, so either this thread sees
+   * the queue run low or the pop sees this thread sleeping and wakes it */
+  atomic_fetch_add(&pool->sleepers, 1u);
+  atomic_thread_fence(memory_order_seq_cst);
+  if (!atomic_load(&pool->stop)) {
+    if (0 != timeout_ns) {
+      struct timespec until;
+      clock_gettime(CLOCK_REALTIME, &until);
+      until.tv_sec += timeout_ns / 1000000000L;
+      until.tv_nsec += timeout_ns % 1000000000L;
+      if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&pool->refill, &pool->lock, &until);
+    } else if (!pool_wanted(pool)) {
+      pthread_cond_wait(&pool->refill, &pool->lock);
+    }
+  }
+  atomic_fetch_sub(&pool->sleepers, 1u);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Refill thread, tops up whichever queues aren't full until stopped.
+ *
+ * @param arg   [in/out]    The POOL_WORKER for the thread.
+ * @return void* Always NULL.
+ */
+static void *pool_worker(void *arg) {
+  POOL_WORKER *worker = arg;
+  MINESWEEPER_POOL *pool = worker->pool;
+  MINESWEEPER_POOL_BOARD board;
+  MINESWEEPER_RANDOM rng;
+
+  uint32_t rejects = 0;
+  long backoff = POOL_BACKOFF_MIN_NS;
+
+  minesweeper_random_seed(&rng, pool->config.seed, worker->stream);
+  while (!atomic_load_explicit(&pool->stop, memory_order_relaxed)) {
+    bool full = true;
+
+    for (uint32_t p = 0; p < MINESWEEPER_POOL_PRESETS; p++) {
+      POOL_QUEUE *queue = &pool->queues[p];
+      if (pool_depth(queue) > queue->mask) {
+        continue;
+      }
+      full = false;
+      uint64_t began = pool_now_ns();
+      if (!pool_generate(pool, (MINESWEEPER_PRESET)p, &rng, &board)) {
+        atomic_fetch_add_explicit(&queue->rejected, 1u, memory_order_relaxed);
+        rejects++;
+      } else if (pool_push(queue, &board)) {
+        atomic_fetch_add_explicit(&queue->generated, 1u,
+                                  memory_order_relaxed);
+        rejects = 0;
+        backoff = POOL_BACKOFF_MIN_NS;
+      }
+      /* Only time spent working counts, so sleeping doesn't lower the rate */
+      atomic_fetch_add_explicit(&queue->busy_ns, pool_now_ns() - began,
+                                memory_order_relaxed);
+    }
+
+    if (full) {
+      /* Every queue is full, wait for some boards to be taken */
+      pool_sleep(pool, 0);
+    } else if (rejects >= POOL_REJECT_RUN) {
+      /* The 3BV limits may be hard or impossible to meet, don't spin on them */
+      pool_sleep(pool, backoff);
+      backoff = (backoff < (POOL_BACKOFF_MAX_NS / 2)) ? (backoff * 2)
+                                                       : POOL_BACKOFF_MAX_NS;
+      rejects = 0;
+    }
+  }
+
+  return NULL;
+}
+
+MINESWEEPER_POOL *
+minesweeper_pool_create(const MINESWEEPER_POOL_CONFIG *config) {
+  if ((NULL == config) || (0u == config->capacity) ||
+      (config->capacity > (UINT32_MAX / 2u))) {
+    return NULL;
+  }
+  for (uint32_t p = 0; p < MINESWEEPER_POOL_PRESETS; p++) {
+    if ((0u != config->max_bbbv[p]) &&
+        (config->min_bbbv[p] > config->max_bbbv[p])) {
+      return NULL;
+    }
+  }
+
+  /* aligned_alloc needs the size to be a multiple of the alignment */
+  size_t size = ((sizeof(MINESWEEPER_POOL) + POOL_CACHE_LINE - 1u) /
+                 POOL_CACHE_LINE) *
+                POOL_CACHE_LINE;
+  MINESWEEPER_POOL *pool = aligned_alloc(POOL_CACHE_LINE, size);
+  if (NULL == pool) {
+    return NULL;
+  }
+  memset(pool, 0, size);
+  pool->config = *config;
+  atomic_init(&pool->stop, false);
+  atomic_init(&pool->sleepers, 0u);
+  atomic_init(&pool->next_id, 0u);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->refill, NULL);
+
+  size_t capacity = 1u;
+  while (capacity < config->capacity) {
+    capacity <<= 1;
+  }
+  for (uint32_t p = 0; p < MINESWEEPER_POOL_PRESETS; p++) {
+    POOL_QUEUE *queue = &pool->queues[p];
+    queue->cells = malloc(capacity * sizeof(*queue->cells));
+    if (NULL == queue->cells) {
+      minesweeper_pool_destroy(pool);
+      return NULL;
+    }
+    queue->mask = capacity - 1u;
+    queue->low_water = (uint32_t)(queue->mask / 2u) + 1u;
+    atomic_init(&queue->enqueue, 0u);
+    atomic_init(&queue->dequeue, 0u);
+    atomic_init(&queue->generated, 0u);
+    atomic_init(&queue->rejected, 0u);
+    atomic_init(&queue->busy_ns, 0u);
+    atomic_init(&queue->popped, 0u);
+    atomic_init(&queue->empty, 0u);
+    for (size_t i = 0; i < capacity; i++) {
+      atomic_init(&queue->cells[i].sequence, i);
+    }
+  }
+
+  uint32_t threads = minesweeper_threads_count(config->threads, UINT32_MAX);
+  pool->workers = calloc(threads, sizeof(*pool->workers));
+  if (NULL == pool->workers) {
+    minesweeper_pool_destroy(pool);
+    return NULL;
+  }
+  pool->worker_count = threads;
+
+  for (uint32_t i = 0; i < threads; i++) {
+    POOL_WORKER *worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->stream = i;
+    worker->started =
+        (0 == pthread_create(&worker->id, NULL, pool_worker, worker));
+    if (!worker->started) {
+      minesweeper_pool_destroy(pool);
+      return NULL;
+    }
+  }
+
+  return pool;
+}
+
+bool minesweeper_pool_pop(MINESWEEPER_POOL *pool, MINESWEEPER_PRESET preset,
+                          MINESWEEPER_POOL_BOARD *board) {
+  if ((NULL == pool) || (NULL == board) ||
+      ((uint32_t)preset >= MINESWEEPER_POOL_PRESETS)) {
+    return false;
+  }
+
+  POOL_QUEUE *queue = &pool->queues[preset];
+  if (!pool_take(queue, board)) {
+    atomic_fetch_add_explicit(&queue->empty, 1u, memory_order_relaxed);
+    return false;
+  }
+  atomic_fetch_add_explicit(&queue->popped, 1u, memory_order_relaxed);
+
+  /* Only take the lock when a refill thread is asleep and there's work */
+  atomic_thread_fence(memory_order_seq_cst);
+  if ((atomic_load_explicit(&pool->sleepers, memory_order_relaxed) > 0u) &&
+      (pool_depth(queue) < queue->low_water)) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->refill);
+    pthread_mutex_unlock(&pool->lock);
+  }
+  return true;
+}
+
+MINESWEEPER_RESULT minesweeper_pool_new_game(MINESWEEPER_POOL *pool,
+                                             MINESWEEPER_BOARD *board,
+                                             MINESWEEPER_POOL_BOARD *ready) {
+  MINESWEEPER_POOL_BOARD taken;
+  MINESWEEPER_POOL_BOARD *pool_board = (NULL != ready) ? ready : &taken;
+
+  if (NULL == board) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  /* Look the preset up, the board may be on the generic engine */
+  MINESWEEPER_PRESET preset =
+      minesweeper_preset_find(board->width, board->height, board->mine_count);
+  if (MINESWEEPER_PRESET_CUSTOM == preset) {
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+  if (!minesweeper_pool_pop(pool, preset, pool_board)) {
+    return MINESWEEPER_RESULT_EMPTY;
+  }
+
+  return minesweeper_board_reset(board, pool_board->mines);
+}
+
+void minesweeper_pool_stats(MINESWEEPER_POOL *pool,
+                            MINESWEEPER_POOL_STATS *stats) {
+  for (uint32_t p = 0; p < MINESWEEPER_POOL_PRESETS; p++) {
+    POOL_QUEUE *queue = &pool->queues[p];
+    stats->depth[p] = pool_depth(queue);
+    stats->generated[p] = atomic_load(&queue->generated);
+    stats->rejected[p] = atomic_load(&queue->rejected);
+    stats->popped[p] = atomic_load(&queue->popped);
+    stats->empty[p] = atomic_load(&queue->empty);
+    double seconds = (double)atomic_load(&queue->busy_ns) / 1e9;
+    stats->refill_rate[p] =
+        (seconds > 0.0) ? ((double)stats->generated[p] / seconds) : 0.0;
+  }
+}
+
+void minesweeper_pool_destroy(MINESWEEPER_POOL *pool) {
+  if (NULL == pool) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  atomic_store(&pool->stop, true);
+  pthread_cond_broadcast(&pool->refill);
+  pthread_mutex_unlock(&pool->lock);
+  for (uint32_t i = 0; i < pool->worker_count; i++) {
+    if (pool->workers[i].started) {
+      pthread_join(pool->workers[i].id, NULL);
+    }
+  }
+  for (uint32_t p = 0; p < MINESWEEPER_POOL_PRESETS; p++) {
+    free(pool->queues[p].cells);
+  }
+  pthread_cond_destroy(&pool->refill);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  free(pool);
+}
@@ -0,0 +1,120 @@
+#include "minesweeper_random.h"
+#include <string.h>
+
+/* Enough bits to mark every point on the largest possible board */
+#define RANDOM_MAX_POINTS (UINT8_MAX * UINT8_MAX)
+#define RANDOM_USED_WORDS ((RANDOM_MAX_POINTS + 63u) / 64u)
+
+/**
+ * @brief Rotates a 64 bit value left.
+ *
+ * @param x [in]    The value to rotate.
+ * @param k [in]    The number of bits to rotate by (1 to 63).
+ * @return uint64_t The rotated value.
+ */
+static inline uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief splitmix64, used to expand the seed into the generator state.
+ *
+ * @param x [in/out]    The splitmix state.
+ * @return uint64_t The next value.
+ */
+static uint64_t splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9E3779B97F4A7C15u);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Advances the generator by 2^128 steps, giving a new stream which
+ * won't overlap with the previous one.
+ *
+ * @param rng   [in/out]    The generator.
+ */
+static void random_jump(MINESWEEPER_RANDOM *rng) {
+  static const uint64_t jump[] = {0x180EC6D33CFD0ABAu, 0xD5A61266F0C9392Cu,
+                                  0xA9582618E03FC9AAu, 0x39ABDC4529B1661Cu};
+  uint64_t s[4] = {0, 0, 0, 0};
+
+  for (uint32_t i = 0; i < (sizeof(jump) / sizeof(jump[0])); i++) {
+    for (int b = 0; b < 64; b++) {
+      if (jump[i] & (UINT64_C(1) << b)) {
+        s[0] ^= rng->state[0];
+        s[1] ^= rng->state[1];
+        s[2] ^= rng->state[2];
+        s[3] ^= rng->state[3];
+      }
+      minesweeper_random_next(rng);
+    }
+  }
+  memcpy(rng->state, s, sizeof(s));
+}
+
+void minesweeper_random_seed(MINESWEEPER_RANDOM *rng, uint64_t seed,
+                             uint32_t stream) {
+  for (uint32_t i = 0; i < 4u; i++) {
+    rng->state[i] = splitmix64(&seed);
+  }
+  for (uint32_t i = 0; i < stream; i++) {
+    random_jump(rng);
+  }
+}
+
+uint64_t minesweeper_random_next(MINESWEEPER_RANDOM *rng) {
+  uint64_t *s = rng->state;
+  uint64_t result = rotl(s[1] * 5u, 7) * 9u;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+uint32_t minesweeper_random_below(MINESWEEPER_RANDOM *rng, uint32_t bound) {
+  /* Lemire's multiply and shift, rejecting the few biased values */
+  uint64_t m = (minesweeper_random_next(rng) >> 32) * bound;
+  uint32_t low = (uint32_t)m;
+
+  if (low < bound) {
+    uint32_t threshold = (0u - bound) % bound;
+    while (low < threshold) {
+      m = (minesweeper_random_next(rng) >> 32) * bound;
+      low = (uint32_t)m;
+    }
+  }
+
+  return (uint32_t)(m >> 32);
+}
+
+void minesweeper_random_mines(MINESWEEPER_RANDOM *rng,
+                              minesweeper_coordinate width,
+                              minesweeper_coordinate height,
+                              uint16_t mine_count, MINESWEEPER_POINT *mines) {
+  uint64_t used[RANDOM_USED_WORDS];
+  uint32_t size = (uint32_t)width * height;
+
+  /* Only clear the part of the bitmap that this board uses */
+  memset(used, 0, ((size + 63u) / 64u) * sizeof(used[0]));
+
+  /* Floyd's algorithm, exactly one random number per mine */
+  for (uint32_t j = size - mine_count, i = 0; j < size; j++, i++) {
+    uint32_t index = minesweeper_random_below(rng, j + 1u);
+    uint64_t bit = UINT64_C(1) << (index % 64u);
+    if (used[index / 64u] & bit) {
+      index = j;
+      bit = UINT64_C(1) << (index % 64u);
+    }
+    used[index / 64u] |= bit;
+    mines[i].x = (minesweeper_coordinate)(index / height);
+    mines[i].y = (minesweeper_coordinate)(index % height);
+  }
+}
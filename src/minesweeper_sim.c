@@ -0,0 +1,336 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_sim.h"
+#include "minesweeper_threads.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Random probes the random strategy makes before scanning for a point */
+#define SIM_RANDOM_PROBES (16u)
+
+/**
+ * @brief Everything a single simulation thread needs.
+ *
+ */
+typedef struct {
+  const MINESWEEPER_SIM_CONFIG *config; /*! The simulation being run */
+  uint64_t games;                       /*! Games for this thread to play */
+  uint32_t stream;                      /*! Generator stream for this thread */
+  MINESWEEPER_RESULT result;            /*! Result of the thread */
+  MINESWEEPER_SIM_STATS stats;          /*! Results for this thread */
+} SIM_WORKER;
+
+/* What the player can see of each state, mines stay hidden until shown */
+static const uint8_t sim_view_of[] = {
+    [MINESWEEPER_STATE_MINE_HIDDEN] = MINESWEEPER_SIM_VIEW_HIDDEN,
+    [MINESWEEPER_STATE_MINE_SHOWN] = MINESWEEPER_SIM_VIEW_MINE,
+    [MINESWEEPER_STATE_MINE_FLAGGED] = MINESWEEPER_SIM_VIEW_FLAGGED,
+    [MINESWEEPER_STATE_CLEAR_HIDDEN] = MINESWEEPER_SIM_VIEW_HIDDEN,
+    [MINESWEEPER_STATE_CLEAR_SHOWN] = MINESWEEPER_SIM_VIEW_CLEAR,
+    [MINESWEEPER_STATE_CLEAR_FLAGGED] = MINESWEEPER_SIM_VIEW_FLAGGED,
+};
+
+/**
+ * @brief Updates the player's view of a board after a move.
+ *
+ * A move only changes the point and its neighbours, unless the game was lost.
+ *
+ * @param points    [out]   The view to update.
+ * @param board     [in]    The board being played.
+ * @param point     [in]    The point moved on, or NULL to update every point.
+ */
+static void sim_view_update(uint8_t *points, const MINESWEEPER_BOARD *board,
+                            const MINESWEEPER_POINT *point) {
+  uint32_t height = board->height;
+  uint32_t first_x = 0;
+  uint32_t last_x = board->width;
+  uint32_t first_y = 0;
+  uint32_t last_y = height;
+
+  if (NULL != point) {
+    first_x = (point->x > 0u) ? (point->x - 1u) : 0u;
+    last_x = ((point->x + 2u) < last_x) ? (point->x + 2u) : last_x;
+    first_y = (point->y > 0u) ? (point->y - 1u) : 0u;
+    last_y = ((point->y + 2u) < last_y) ? (point->y + 2u) : last_y;
+  }
+  for (uint32_t x = first_x; x < last_x; x++) {
+    for (uint32_t y = first_y; y < last_y; y++) {
+      points[(x * height) + y] = sim_view_of[board->grid[(x * height) + y]];
+    }
+  }
+}
+
+/**
+ * @brief Plays a single game on a new random board.
+ *
+ * @param config    [in]        The simulation being run.
+ * @param board     [in/out]    The board to play on.
+ * @param view      [in/out]    The player's view of the board.
+ * @param points    [out]       Storage for the view's points.
+ * @param rng       [in/out]    The generator for this thread.
+ * @param mines     [out]       Storage for the mine locations.
+ * @param stats     [in/out]    Results to update.
+ */
+static void sim_play(const MINESWEEPER_SIM_CONFIG *config,
+                     MINESWEEPER_BOARD *board, MINESWEEPER_SIM_VIEW *view,
+                     uint8_t *points, MINESWEEPER_RANDOM *rng,
+                     MINESWEEPER_POINT *mines, MINESWEEPER_SIM_STATS *stats) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+  uint32_t moves = 0;
+
+  minesweeper_random_mines(rng, board->width, board->height,
+                           board->mine_count, mines);
+  minesweeper_board_reset(board, mines);
+  sim_view_update(points, board, NULL);
+  stats->games++;
+
+  while (MINESWEEPER_RESULT_SUCCESS == result) {
+    MINESWEEPER_SIM_MOVE move = {{0, 0}, false, false};
+    view->shown_points = board->shown_points;
+    if (!config->strategy(view, rng, config->context, &move)) {
+      stats->resigns++;
+      break;
+    }
+    moves++;
+
+    if (move.is_flag) {
+      stats->flags++;
+      result = minesweeper_board_flag(board, &move.point);
+    } else {
+      uint16_t shown_before = board->shown_points;
+      stats->picks++;
+      stats->guesses += move.is_guess;
+      result = minesweeper_board_pick(board, &move.point);
+      if ((MINESWEEPER_RESULT_SUCCESS == result) ||
+          (MINESWEEPER_RESULT_WIN == result)) {
+        uint16_t cascade = (uint16_t)(board->shown_points - shown_before);
+        stats->revealed += cascade;
+        stats->cascades[cascade]++;
+      }
+    }
+
+    sim_view_update(points, board,
+                    (MINESWEEPER_RESULT_LOSE == result) ? NULL : &move.point);
+
+    switch (result) {
+    case MINESWEEPER_RESULT_SUCCESS:
+      break;
+    case MINESWEEPER_RESULT_WIN:
+      stats->wins++;
+      break;
+    case MINESWEEPER_RESULT_LOSE:
+      stats->losses++;
+      break;
+    default:
+      /* The strategy made an invalid move, give up on the game */
+      stats->errors++;
+      break;
+    }
+  }
+
+  if (moves > stats->max_moves) {
+    stats->max_moves = moves;
+  }
+}
+
+/**
+ * @brief Plays all the games for one thread.
+ *
+ * @param arg   [in/out]    The SIM_WORKER for the thread.
+ * @return void* Always NULL, the result is stored in the worker.
+ */
+static void *sim_worker(void *arg) {
+  SIM_WORKER *worker = arg;
+  const MINESWEEPER_SIM_CONFIG *config = worker->config;
+  MINESWEEPER_SIM_STATS stats;
+  MINESWEEPER_BOARD board;
+  MINESWEEPER_RANDOM rng;
+  MINESWEEPER_EVENT_RING *ring = NULL;
+  size_t size = (size_t)config->width * config->height;
+
+  MINESWEEPER_STATE *grid = malloc(size * sizeof(*grid));
+  uint8_t *points = malloc(size);
+  /* At least one point, so a board with no mines still gets storage */
+  MINESWEEPER_POINT *mines =
+      malloc(((size_t)config->mine_count + 1u) * sizeof(*mines));
+  MINESWEEPER_SIM_VIEW view = {points, config->width, config->height,
+                               config->mine_count, 0};
+  if ((NULL == grid) || (NULL == points) || (NULL == mines)) {
+    worker->result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+  } else {
+    worker->result = minesweeper_board_init(&board, grid, config->width,
+                                            config->height, config->mine_count);
+  }
+
+  if ((MINESWEEPER_RESULT_SUCCESS == worker->result) &&
+      (NULL != config->events)) {
+    ring = minesweeper_events_ring(config->events);
+    board.events = ring;
+    if (NULL == ring) {
+      worker->result = MINESWEEPER_RESULT_UNKNOWN_ERR;
+    }
+  }
+
+  if (MINESWEEPER_RESULT_SUCCESS == worker->result) {
+    /* Count locally, workers share cache lines so only write back once */
+    uint64_t games = worker->games;
+    memset(&stats, 0, sizeof(stats));
+    minesweeper_random_seed(&rng, config->seed, worker->stream);
+    for (uint64_t i = 0; i < games; i++) {
+      sim_play(config, &board, &view, points, &rng, mines, &stats);
+    }
+    worker->stats = stats;
+  }
+
+  /* Let the flusher free the ring, so repeated runs don't grow the sink.
+   * board is left uninitialised if an allocation failed, so don't use it. */
+  minesweeper_events_ring_release(ring);
+  free(grid);
+  free(points);
+  free(mines);
+  return NULL;
+}
+
+/**
+ * @brief Adds the results of one thread to the total.
+ *
+ * @param total [in/out]    The combined results.
+ * @param stats [in]        The results to add.
+ */
+static void sim_merge(MINESWEEPER_SIM_STATS *total,
+                      const MINESWEEPER_SIM_STATS *stats) {
+  total->games += stats->games;
+  total->wins += stats->wins;
+  total->losses += stats->losses;
+  total->resigns += stats->resigns;
+  total->errors += stats->errors;
+  total->picks += stats->picks;
+  total->flags += stats->flags;
+  total->guesses += stats->guesses;
+  total->revealed += stats->revealed;
+  for (uint32_t i = 0; i <= MINESWEEPER_SIM_MAX_CASCADE; i++) {
+    total->cascades[i] += stats->cascades[i];
+  }
+  if (stats->max_moves > total->max_moves) {
+    total->max_moves = stats->max_moves;
+  }
+}
+
+MINESWEEPER_RESULT minesweeper_sim_run(const MINESWEEPER_SIM_CONFIG *config,
+                                       MINESWEEPER_SIM_STATS *stats) {
+  MINESWEEPER_RESULT result = MINESWEEPER_RESULT_SUCCESS;
+
+  if ((NULL == config) || (NULL == stats) || (NULL == config->strategy)) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  if ((0u == config->width) || (0u == config->height) ||
+      (config->mine_count >= ((uint32_t)config->width * config->height))) {
+    return MINESWEEPER_RESULT_OUT_OF_BOUNDS;
+  }
+  memset(stats, 0, sizeof(*stats));
+
+  uint32_t threads = minesweeper_threads_count(config->threads, config->games);
+  SIM_WORKER *workers = calloc(threads, sizeof(*workers));
+  if (NULL == workers) {
+    return MINESWEEPER_RESULT_UNKNOWN_ERR;
+  }
+  for (uint32_t i = 0; i < threads; i++) {
+    workers[i].config = config;
+    workers[i].stream = i;
+    /* Share out the games, the first threads take any remainder */
+    workers[i].games = (config->games / threads) +
+                       ((i < (config->games % threads)) ? 1u : 0u);
+  }
+  minesweeper_threads_run(sim_worker, workers, sizeof(*workers), threads);
+
+  for (uint32_t i = 0; i < threads; i++) {
+    if (MINESWEEPER_RESULT_SUCCESS != workers[i].result) {
+      result = workers[i].result;
+    }
+    sim_merge(stats, &workers[i].stats);
+  }
+
+  free(workers);
+  return result;
+}
+
+bool minesweeper_sim_strategy_random(const MINESWEEPER_SIM_VIEW *view,
+                                     MINESWEEPER_RANDOM *rng, void *context,
+                                     MINESWEEPER_SIM_MOVE *move) {
+  (void)context;
+  uint32_t size = (uint32_t)view->width * view->height;
+  uint32_t index = minesweeper_random_below(rng, size);
+  bool found = (MINESWEEPER_SIM_VIEW_HIDDEN == view->points[index]);
+
+  /* Most of the board is hidden for most of the game, so probe first */
+  for (uint32_t i = 1; (i < SIM_RANDOM_PROBES) && !found; i++) {
+    index = minesweeper_random_below(rng, size);
+    found = (MINESWEEPER_SIM_VIEW_HIDDEN == view->points[index]);
+  }
+  /* Otherwise take the next hidden point along */
+  for (uint32_t i = 0; (i < size) && !found; i++) {
+    index = (index + 1u < size) ? (index + 1u) : 0u;
+    found = (MINESWEEPER_SIM_VIEW_HIDDEN == view->points[index]);
+  }
+
+  if (found) {
+    move->point.x = (minesweeper_coordinate)(index / view->height);
+    move->point.y = (minesweeper_coordinate)(index % view->height);
+    move->is_flag = false;
+    /* Never uses what's been revealed, so every pick is a guess */
+    move->is_guess = true;
+  }
+
+  return found;
+}
+
+bool minesweeper_sim_strategy_greedy(const MINESWEEPER_SIM_VIEW *view,
+                                     MINESWEEPER_RANDOM *rng, void *context,
+                                     MINESWEEPER_SIM_MOVE *move) {
+  (void)context;
+  uint32_t width = view->width;
+  uint32_t height = view->height;
+  uint32_t shown_mines = 0;
+  uint32_t best_score = 0;
+  uint32_t ties = 0;
+
+  for (uint32_t x = 0; x < width; x++) {
+    for (uint32_t y = 0; y < height; y++) {
+      uint8_t state = view->points[(x * height) + y];
+      if (MINESWEEPER_SIM_VIEW_MINE == state) {
+        shown_mines++;
+      }
+      if (MINESWEEPER_SIM_VIEW_HIDDEN != state) {
+        continue;
+      }
+
+      /* Score by how many hidden points picking here would reveal */
+      uint32_t score = 0;
+      for (uint32_t i = (x > 0u) ? (x - 1u) : 0u; (i <= x + 1u) && (i < width);
+           i++) {
+        for (uint32_t j = (y > 0u) ? (y - 1u) : 0u;
+             (j <= y + 1u) && (j < height); j++) {
+          score += (MINESWEEPER_SIM_VIEW_HIDDEN ==
+                    view->points[(i * height) + j]);
+        }
+      }
+
+      if (score > best_score) {
+        best_score = score;
+        ties = 1;
+        move->point.x = (minesweeper_coordinate)x;
+        move->point.y = (minesweeper_coordinate)y;
+      } else if ((score == best_score) &&
+                 (0u == minesweeper_random_below(rng, ++ties))) {
+        /* Keep each tied point with equal chance */
+        move->point.x = (minesweeper_coordinate)x;
+        move->point.y = (minesweeper_coordinate)y;
+      }
+    }
+  }
+
+  move->is_flag = false;
+  /* Once every mine has been revealed, all hidden points are clear */
+  move->is_guess = (shown_mines < view->mine_count);
+
+  return best_score > 0u;
+}
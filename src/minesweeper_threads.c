@@ -0,0 +1,46 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper_threads.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+uint32_t minesweeper_threads_count(uint32_t threads, uint64_t work) {
+  if (0u == threads) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (cores > 0) ? (uint32_t)cores : 1u;
+  }
+  /* No point having threads with nothing to do */
+  if (threads > work) {
+    threads = (work > 0u) ? (uint32_t)work : 1u;
+  }
+  return threads;
+}
+
+void minesweeper_threads_run(MINESWEEPER_THREADS_WORKER worker, void *args,
+                             size_t arg_size, uint32_t count) {
+  uint8_t *arg = args;
+  pthread_t *ids = calloc(count, sizeof(*ids));
+  bool *started = calloc(count, sizeof(*started));
+
+  /* Without the bookkeeping every share runs here, one after another */
+  if ((NULL != ids) && (NULL != started)) {
+    for (uint32_t i = 1; i < count; i++) {
+      started[i] = (0 == pthread_create(&ids[i], NULL, worker,
+                                        &arg[(size_t)i * arg_size]));
+    }
+  }
+  if (count > 0u) {
+    worker(arg);
+  }
+  for (uint32_t i = 1; i < count; i++) {
+    if ((NULL != started) && started[i]) {
+      pthread_join(ids[i], NULL);
+    } else {
+      worker(&arg[(size_t)i * arg_size]);
+    }
+  }
+
+  free(ids);
+  free(started);
+}
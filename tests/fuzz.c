@@ -0,0 +1,564 @@
+#define _POSIX_C_SOURCE 200809L
+#include "minesweeper.h"
+#include "minesweeper_board.h"
+#include "minesweeper_random.h"
+#include "minesweeper_threads.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Differential fuzzing of the board engines
+ *
+ * Each input is a move sequence replayed against the reference in
+ * src/minesweeper.c, a board on its preset's engine and the same board forced
+ * onto the generic engine. Every result and every grid must match.
+ *
+ *   preset seed corrupt (command arguments...)...
+ *
+ * The first byte picks the preset. Only Beginner is the reference's size, the
+ * larger presets check their engine against the generic one. The game is then
+ * reset with mines from a 4 byte seed, corrupted if corrupt % 16 is 0 (out of
+ * bounds mine) or 1 (duplicate mine), leaving it not initialised.
+ *
+ * Each command is a byte, modulo 16, followed by its arguments. Coordinates are
+ * taken modulo one more than the board size so out of bounds points are
+ * reached too.
+ *
+ *   0-1    pick at x y
+ *   2-11   pick the first hidden clear point from x y
+ *   12     pick hidden clear points from x y until the game ends, so any
+ *          preset can be won
+ *   13-14  flag at x y
+ *   15     reset with seed corrupt
+ *
+ * Sequences stop at the first truncated command. The same inputs work with
+ * libFuzzer (built with MINESWEEPER_LIBFUZZER) and the random runner, so
+ * failures from either can be replayed by both.
+ */
+
+/* Bytes of arguments to each command */
+#define FUZZ_POINT_BYTES (2u)
+#define FUZZ_RESET_BYTES (5u)
+
+/**
+ * @brief Counts of what the replays reached, to show the coverage is useful.
+ *
+ */
+typedef struct {
+  uint64_t sequences;  /*! Inputs replayed */
+  uint64_t moves;      /*! Commands replayed */
+  uint64_t wins;       /*! Games won */
+  uint64_t losses;     /*! Games lost */
+  uint64_t bad_resets; /*! Resets rejected for invalid mines */
+} FUZZ_TOTALS;
+
+/**
+ * @brief Every engine being compared, plus what the replays reached.
+ *
+ */
+typedef struct {
+  MINESWEEPER_BOARD preset;  /*! Board on its preset's engine */
+  MINESWEEPER_BOARD generic; /*! Board forced onto the generic engine */
+  MINESWEEPER_STATE preset_grid[MINESWEEPER_PRESET_MAX_SIZE]; /*! Its grid */
+  MINESWEEPER_STATE generic_grid[MINESWEEPER_PRESET_MAX_SIZE]; /*! Its grid */
+  MINESWEEPER_STATE reference[MINESWEEPER_BOARD_WIDTH]
+                             [MINESWEEPER_BOARD_HEIGHT]; /*! Reference grid */
+  bool has_reference; /*! Whether the preset is the reference's size */
+  FUZZ_TOTALS totals; /*! What the replays have reached */
+} FUZZ_ENGINES;
+
+/* The reference keeps its state in globals, so only one replay at a time */
+static FUZZ_ENGINES engines;
+
+/**
+ * @brief Sends the reference's messages nowhere, they would swamp the output.
+ *
+ */
+static void fuzz_silence_reference(void) {
+  if (NULL != freopen("/dev/null", "w", stdout)) {
+    setvbuf(stdout, NULL, _IOFBF, 1u << 16);
+  }
+}
+
+/**
+ * @brief Checks every engine agrees after a command, and that the result is
+ * consistent with the board.
+ *
+ * @param command   [in]    Name of the command, for the report.
+ * @param point     [in]    The point the command was for.
+ * @param preset    [in]    Result from the preset engine.
+ * @param generic   [in]    Result from the generic engine.
+ * @param reference [in]    Result from the reference, if it's being compared.
+ * @return true     Everything matches.
+ * @return false    A mismatch, which has been reported to stderr.
+ */
+static bool fuzz_check(const char *command, const MINESWEEPER_POINT *point,
+                       MINESWEEPER_RESULT preset, MINESWEEPER_RESULT generic,
+                       MINESWEEPER_RESULT reference) {
+  const MINESWEEPER_BOARD *board = &engines.preset;
+  uint32_t size = (uint32_t)board->width * board->height;
+  engines.totals.moves++;
+  size_t bytes = size * sizeof(MINESWEEPER_STATE);
+  const char *error = NULL;
+  uint32_t shown = 0;
+  uint32_t hidden = 0;
+
+  /* Branch free so it vectorises, this runs after every command */
+  for (uint32_t i = 0; i < size; i++) {
+    MINESWEEPER_STATE state = board->grid[i];
+    shown += (MINESWEEPER_STATE_CLEAR_SHOWN == state);
+    hidden += (MINESWEEPER_STATE_MINE_SHOWN != state) &
+              (MINESWEEPER_STATE_CLEAR_SHOWN != state);
+  }
+
+  if (preset != generic) {
+    error = "preset and generic results differ";
+  } else if (engines.has_reference && (preset != reference)) {
+    error = "preset and reference results differ";
+  } else if (0 != memcmp(engines.preset_grid, engines.generic_grid, bytes)) {
+    error = "preset and generic grids differ";
+  } else if (engines.has_reference &&
+             (0 != memcmp(engines.preset_grid, engines.reference, bytes))) {
+    error = "preset and reference grids differ";
+  } else if ((board->is_init != engines.generic.is_init) ||
+             (board->shown_points != engines.generic.shown_points)) {
+    error = "preset and generic counters differ";
+  } else if (board->shown_points != shown) {
+    error = "shown points doesn't match the grid";
+  } else if ((MINESWEEPER_RESULT_LOSE == preset) && (0u != hidden)) {
+    error = "points still hidden after a loss";
+  } else if ((MINESWEEPER_RESULT_WIN == preset) &&
+             (shown != (size - board->mine_count))) {
+    error = "won with clear points still hidden";
+  }
+
+  if (NULL != error) {
+    fprintf(stderr,
+            "%ux%u board, %s (%u, %u): %s (preset %u, generic %u, "
+            "reference %u)\n",
+            board->width, board->height, command, point->x, point->y, error,
+            preset, generic, reference);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Moves a point on to the first point from it which is safe to pick.
+ *
+ * @param point [in/out]    The point to start from.
+ * @return true     A hidden clear point was found.
+ * @return false    The board is finished or not initialised, or the point is
+ * out of bounds, so it was left alone.
+ */
+static bool fuzz_find_safe(MINESWEEPER_POINT *point) {
+  const MINESWEEPER_BOARD *board = &engines.preset;
+  uint32_t points = (uint32_t)board->width * board->height;
+
+  if (!board->is_init || (point->x >= board->width) ||
+      (point->y >= board->height)) {
+    return false;
+  }
+
+  uint32_t start = ((uint32_t)point->x * board->height) + point->y;
+  uint32_t index = start;
+  while ((MINESWEEPER_STATE_CLEAR_HIDDEN != board->grid[index]) &&
+         (MINESWEEPER_STATE_CLEAR_FLAGGED != board->grid[index])) {
+    index = ((index + 1u) < points) ? (index + 1u) : 0u;
+    if (start == index) {
+      return false;
+    }
+  }
+  point->x = (minesweeper_coordinate)(index / board->height);
+  point->y = (minesweeper_coordinate)(index % board->height);
+
+  return true;
+}
+
+/**
+ * @brief Picks a point on every engine and checks they agree.
+ *
+ * @param point     [in]    The point to pick.
+ * @param result    [out]   The result from the preset engine.
+ * @return true     Everything matches.
+ * @return false    A mismatch, which has been reported to stderr.
+ */
+static bool fuzz_pick(MINESWEEPER_POINT *point, MINESWEEPER_RESULT *result) {
+  MINESWEEPER_RESULT reference = MINESWEEPER_RESULT_SUCCESS;
+
+  *result = minesweeper_board_pick(&engines.preset, point);
+  MINESWEEPER_RESULT generic = minesweeper_board_pick(&engines.generic, point);
+  if (engines.has_reference) {
+    reference = minesweeper_pick(engines.reference, point);
+  }
+  engines.totals.wins += (MINESWEEPER_RESULT_WIN == *result);
+  engines.totals.losses += (MINESWEEPER_RESULT_LOSE == *result);
+
+  return fuzz_check("pick", point, *result, generic, reference);
+}
+
+/**
+ * @brief Replays an input against every engine.
+ *
+ * @param data  [in]    The input, see the format above.
+ * @param size  [in]    Number of bytes in the input.
+ * @return true     Every engine agreed on the whole sequence.
+ * @return false    A mismatch, which has been reported to stderr.
+ */
+static bool fuzz_replay(const uint8_t *data, size_t size) {
+  MINESWEEPER_POINT mines[MINESWEEPER_PRESET_MAX_MINES];
+  MINESWEEPER_RANDOM rng;
+  size_t position = 0;
+
+  engines.totals.sequences++;
+  if (size < (1u + FUZZ_RESET_BYTES)) {
+    return true;
+  }
+  MINESWEEPER_PRESET preset = (MINESWEEPER_PRESET)(
+      data[position++] % (uint32_t)MINESWEEPER_PRESET_CUSTOM);
+  minesweeper_board_init_preset(&engines.preset, engines.preset_grid, preset);
+  minesweeper_board_init_preset(&engines.generic, engines.generic_grid,
+                                preset);
+  engines.generic.preset = MINESWEEPER_PRESET_CUSTOM;
+
+  minesweeper_coordinate width = engines.preset.width;
+  minesweeper_coordinate height = engines.preset.height;
+  uint16_t mine_count = engines.preset.mine_count;
+  engines.has_reference = (MINESWEEPER_BOARD_WIDTH == width) &&
+                          (MINESWEEPER_BOARD_HEIGHT == height) &&
+                          (MINESWEEPER_MINE_COUNT == mine_count);
+
+  /* The first command is always a reset */
+  for (bool first = true; position < size; first = false) {
+    uint8_t command = first ? 15u : (data[position++] % 16u);
+    MINESWEEPER_RESULT preset_result;
+    MINESWEEPER_RESULT generic_result;
+    MINESWEEPER_RESULT reference_result = MINESWEEPER_RESULT_SUCCESS;
+    MINESWEEPER_RESULT result;
+    MINESWEEPER_POINT point = {0, 0};
+
+    if (command < 15u) {
+      if ((size - position) < FUZZ_POINT_BYTES) {
+        break;
+      }
+      point.x = (minesweeper_coordinate)(data[position] % (width + 1u));
+      point.y = (minesweeper_coordinate)(data[position + 1u] % (height + 1u));
+      position += FUZZ_POINT_BYTES;
+    }
+
+    if (command < 12u) {
+      if (command >= 2u) {
+        fuzz_find_safe(&point);
+      }
+      if (!fuzz_pick(&point, &result)) {
+        return false;
+      }
+    } else if (12u == command) {
+      /* Play the game out, checking after every pick */
+      do {
+        if (!fuzz_find_safe(&point)) {
+          break;
+        }
+        if (!fuzz_pick(&point, &result)) {
+          return false;
+        }
+      } while (MINESWEEPER_RESULT_SUCCESS == result);
+    } else if (command < 15u) {
+      preset_result = minesweeper_board_flag(&engines.preset, &point);
+      generic_result = minesweeper_board_flag(&engines.generic, &point);
+      if (engines.has_reference) {
+        reference_result = minesweeper_flag(engines.reference, &point);
+      }
+      if (!fuzz_check("flag", &point, preset_result, generic_result,
+                      reference_result)) {
+        return false;
+      }
+    } else {
+      if ((size - position) < FUZZ_RESET_BYTES) {
+        break;
+      }
+      uint32_t seed = (uint32_t)data[position] |
+                      ((uint32_t)data[position + 1u] << 8) |
+                      ((uint32_t)data[position + 2u] << 16) |
+                      ((uint32_t)data[position + 3u] << 24);
+      uint8_t corrupt = data[position + 4u];
+      uint16_t corrupted = (uint16_t)((corrupt >> 4) % mine_count);
+      position += FUZZ_RESET_BYTES;
+
+      minesweeper_random_seed(&rng, seed, 0);
+      minesweeper_random_mines(&rng, width, height, mine_count, mines);
+      if (0u == (corrupt % 16u)) {
+        mines[corrupted].x = width;
+      } else if ((1u == (corrupt % 16u)) && (0u != corrupted)) {
+        mines[corrupted] = mines[0];
+      }
+      point = mines[corrupted];
+      preset_result = minesweeper_board_reset(&engines.preset, mines);
+      generic_result = minesweeper_board_reset(&engines.generic, mines);
+      if (engines.has_reference) {
+        reference_result = minesweeper_reset(engines.reference, mines);
+      }
+      engines.totals.bad_resets +=
+          (MINESWEEPER_RESULT_SUCCESS != preset_result);
+      if (!fuzz_check("reset", &point, preset_result, generic_result,
+                      reference_result)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+#ifdef MINESWEEPER_LIBFUZZER
+
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  (void)argc;
+  (void)argv;
+  fuzz_silence_reference();
+  return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (!fuzz_replay(data, size)) {
+    abort();
+  }
+  return 0;
+}
+
+#else
+
+/* Longest input the random runner generates */
+#define FUZZ_MAX_INPUT (256u)
+
+/**
+ * @brief Prints how to use the random runner.
+ *
+ * @param name  [in]    The name the program was run as.
+ */
+static void usage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [-n sequences] [-l length] [-j jobs] [-S seed] [-o file]\n"
+          "       %s file...\n"
+          "\n"
+          "  -n  number of random sequences (default 1000000)\n"
+          "  -l  longest sequence in bytes (default 128, at most %u)\n"
+          "  -j  number of processes (default one per core)\n"
+          "  -S  seed (default 1)\n"
+          "  -o  where to save a failing sequence (default "
+          "differential-failure.bin)\n"
+          "\n"
+          "With files, replays each one instead, such as a saved failure or a\n"
+          "libFuzzer crash.\n",
+          name, name, FUZZ_MAX_INPUT);
+}
+
+/**
+ * @brief Replays inputs saved in files.
+ *
+ * @param paths [in]    The files.
+ * @param count [in]    Number of files.
+ * @return int The exit code.
+ */
+static int replay_files(char *const *paths, int count) {
+  static uint8_t data[1u << 16];
+
+  for (int i = 0; i < count; i++) {
+    FILE *file = fopen(paths[i], "rb");
+    if (NULL == file) {
+      fprintf(stderr, "Couldn't open '%s'\n", paths[i]);
+      return EXIT_FAILURE;
+    }
+    size_t size = fread(data, 1u, sizeof(data), file);
+    fclose(file);
+    if (!fuzz_replay(data, size)) {
+      fprintf(stderr, "%s: engines differ\n", paths[i]);
+      return EXIT_FAILURE;
+    }
+  }
+  fprintf(stderr, "%d inputs replayed, all engines agree\n", count);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Replays random sequences, saving the first one that fails.
+ *
+ * @param seed          [in]    The seed.
+ * @param stream        [in]    Generator stream, different for each job.
+ * @param sequences     [in]    Number of sequences to replay.
+ * @param max_length    [in]    Longest sequence in bytes.
+ * @param failure_path  [in]    Where to save a failing sequence.
+ * @return true     Every sequence passed.
+ * @return false    A sequence failed.
+ */
+static bool run_random(uint64_t seed, uint32_t stream, uint64_t sequences,
+                       uint32_t max_length, const char *failure_path) {
+  uint8_t data[FUZZ_MAX_INPUT];
+  MINESWEEPER_RANDOM rng;
+
+  minesweeper_random_seed(&rng, seed, stream);
+  for (uint64_t n = 0; n < sequences; n++) {
+    uint32_t length = 1u + minesweeper_random_below(&rng, max_length);
+    for (uint32_t i = 0; i < length; i += 8u) {
+      uint64_t bytes = minesweeper_random_next(&rng);
+      for (uint32_t j = 0; (j < 8u) && ((i + j) < length); j++) {
+        data[i + j] = (uint8_t)(bytes >> (8u * j));
+      }
+    }
+
+    if (!fuzz_replay(data, length)) {
+      FILE *file = fopen(failure_path, "wb");
+      if ((NULL != file) && (length == fwrite(data, 1u, length, file))) {
+        fprintf(stderr, "Sequence %llu of job %u failed, saved to %s\n",
+                (unsigned long long)n, stream, failure_path);
+      }
+      if (NULL != file) {
+        fclose(file);
+      }
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  const char *failure_path = "differential-failure.bin";
+  uint64_t sequences = 1000000u;
+  uint32_t max_length = 128u;
+  uint32_t jobs = 0;
+  uint64_t seed = 1u;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:l:j:S:o:")) != -1) {
+    switch (opt) {
+    case 'n':
+      sequences = strtoull(optarg, NULL, 0);
+      break;
+    case 'l':
+      max_length = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'j':
+      jobs = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'S':
+      seed = strtoull(optarg, NULL, 0);
+      break;
+    case 'o':
+      failure_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if ((0u == max_length) || (max_length > FUZZ_MAX_INPUT)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  fflush(stderr);
+  fuzz_silence_reference();
+  if (optind < argc) {
+    return replay_files(&argv[optind], argc - optind);
+  }
+
+  jobs = minesweeper_threads_count(jobs, sequences);
+
+  /* The reference keeps its state in globals, so each job is a process. This
+   * process runs job 0 and collects the other jobs' totals through pipes. */
+  pid_t *pids = calloc(jobs, sizeof(*pids));
+  int *pipes = calloc(jobs, sizeof(*pipes));
+  if ((NULL == pids) || (NULL == pipes)) {
+    free(pids);
+    free(pipes);
+    return EXIT_FAILURE;
+  }
+
+  struct timespec start;
+  struct timespec end;
+  bool passed = true;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (uint32_t i = 1; i < jobs; i++) {
+    uint64_t share = (sequences / jobs) + (i < (sequences % jobs));
+    int fds[2];
+    pids[i] = -1;
+    if (0 != pipe(fds)) {
+      /* Couldn't start the job, so run it here instead */
+      passed = run_random(seed, i, share, max_length, failure_path) && passed;
+      continue;
+    }
+    pids[i] = fork();
+    if (0 == pids[i]) {
+      close(fds[0]);
+      memset(&engines.totals, 0, sizeof(engines.totals));
+      bool job_passed = run_random(seed, i, share, max_length, failure_path);
+      ssize_t written = write(fds[1], &engines.totals, sizeof(engines.totals));
+      _exit((job_passed && (sizeof(engines.totals) == (size_t)written))
+                ? EXIT_SUCCESS
+                : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    if (pids[i] < 0) {
+      close(fds[0]);
+      passed = run_random(seed, i, share, max_length, failure_path) && passed;
+    } else {
+      pipes[i] = fds[0];
+    }
+  }
+
+  uint64_t share = (sequences / jobs) + (0u < (sequences % jobs));
+  passed = run_random(seed, 0, share, max_length, failure_path) && passed;
+
+  FUZZ_TOTALS totals = engines.totals;
+  for (uint32_t i = 1; i < jobs; i++) {
+    FUZZ_TOTALS job;
+    int status = 0;
+    if (pids[i] <= 0) {
+      continue;
+    }
+    if (sizeof(job) == (size_t)read(pipes[i], &job, sizeof(job))) {
+      totals.sequences += job.sequences;
+      totals.moves += job.moves;
+      totals.wins += job.wins;
+      totals.losses += job.losses;
+      totals.bad_resets += job.bad_resets;
+    }
+    close(pipes[i]);
+    waitpid(pids[i], &status, 0);
+    passed = passed && WIFEXITED(status) &&
+             (EXIT_SUCCESS == WEXITSTATUS(status));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  free(pids);
+  free(pipes);
+
+  double seconds = (double)(end.tv_sec - start.tv_sec) +
+                   ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+  fprintf(stderr,
+          "%llu sequences, %llu moves, %llu wins, %llu losses, %llu bad "
+          "resets in %u jobs, %s (%.0f sequences/s)\n",
+          (unsigned long long)totals.sequences,
+          (unsigned long long)totals.moves, (unsigned long long)totals.wins,
+          (unsigned long long)totals.losses,
+          (unsigned long long)totals.bad_resets, jobs,
+          passed ? "all engines agree" : "ENGINES DIFFER",
+          (double)totals.sequences / seconds);
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif /* MINESWEEPER_LIBFUZZER */
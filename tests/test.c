@@ -1,6 +1,15 @@
+#define _POSIX_C_SOURCE 200809L
 #include "../Unity/src/unity.h"
 #include "../include/minesweeper.h"
+#include "../include/minesweeper_analysis.h"
+#include "../include/minesweeper_board.h"
+#include "../include/minesweeper_pool.h"
+#include "../include/minesweeper_sim.h"
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 MINESWEEPER_STATE grid[MINESWEEPER_BOARD_WIDTH][MINESWEEPER_BOARD_HEIGHT] = {0u};
 
@@ -280,6 +289,431 @@ void test_win_game(void) {
     }
 }
 
+void test_board_preset_dispatch(void) {
+    MINESWEEPER_STATE board_grid[MINESWEEPER_PRESET_MAX_SIZE];
+    MINESWEEPER_BOARD board;
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_BEGINNER,
+                           minesweeper_preset_find(MINESWEEPER_BOARD_WIDTH, MINESWEEPER_BOARD_HEIGHT, MINESWEEPER_MINE_COUNT));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_EXPERT, minesweeper_preset_find(30, 16, 99));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_CUSTOM, minesweeper_preset_find(16, 30, 99));
+
+    MINESWEEPER_RESULT result = minesweeper_board_init_preset(&board, board_grid, MINESWEEPER_PRESET_INTERMEDIATE);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(16, board.width);
+    TEST_ASSERT_EQUAL_UINT(40, board.mine_count);
+    result = minesweeper_board_init(&board, board_grid, 5, 5, 3);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_CUSTOM, board.preset);
+    result = minesweeper_board_init(&board, board_grid, 2, 2, 4);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, result);
+
+    minesweeper_coordinate width;
+    minesweeper_coordinate height;
+    uint16_t mine_count;
+    result = minesweeper_preset_size(MINESWEEPER_PRESET_EXPERT, &width, &height, &mine_count);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_EXPERT, minesweeper_preset_find(width, height, mine_count));
+    result = minesweeper_preset_size(MINESWEEPER_PRESET_CUSTOM, &width, &height, &mine_count);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, result);
+
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_INTERMEDIATE, minesweeper_preset_from_name("Intermediate"));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_CUSTOM, minesweeper_preset_from_name("expert2"));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_CUSTOM, minesweeper_preset_from_name("custom"));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_BEGINNER,
+                           minesweeper_preset_from_name(minesweeper_preset_name(MINESWEEPER_PRESET_BEGINNER)));
+}
+
+void test_board_custom_size(void) {
+    MINESWEEPER_STATE board_grid[5 * 3];
+    MINESWEEPER_BOARD board;
+    MINESWEEPER_POINT board_mines[] = {{4, 2}, {0, 2}};
+    MINESWEEPER_RESULT result = minesweeper_board_init(&board, board_grid, 5, 3, 2);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+
+    MINESWEEPER_POINT point = {0, 0};
+    result = minesweeper_board_pick(&board, &point);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_NOT_INIT, result);
+    result = minesweeper_board_reset(&board, board_mines);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_STATE_MINE_HIDDEN, board_grid[(4 * 3) + 2]);
+
+    point.x = 5;
+    result = minesweeper_board_flag(&board, &point);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, result);
+    point.x = 1;
+    point.y = 1;
+    result = minesweeper_board_pick(&board, &point);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_STATE_MINE_SHOWN, board_grid[(0 * 3) + 2]);
+    point.x = 3;
+    result = minesweeper_board_pick(&board, &point);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_WIN, result);
+
+    board_mines[1] = board_mines[0];
+    result = minesweeper_board_reset(&board, board_mines);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, result);
+}
+
+void test_board_preset_mismatch(void) {
+    MINESWEEPER_STATE board_grid[MINESWEEPER_PRESET_MAX_SIZE];
+    MINESWEEPER_BOARD board;
+    MINESWEEPER_POINT board_mines[] = {{4, 2}, {0, 2}};
+    for (uint32_t i = 0; i < MINESWEEPER_PRESET_MAX_SIZE; i++) {
+        board_grid[i] = MINESWEEPER_STATE_CLEAR_FLAGGED;
+    }
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, minesweeper_board_init(&board, board_grid, 5, 3, 2));
+
+    /* A preset that doesn't fit the board falls back to the generic engine */
+    board.preset = MINESWEEPER_PRESET_EXPERT;
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, minesweeper_board_reset(&board, board_mines));
+    MINESWEEPER_POINT point = {1, 1};
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, minesweeper_board_pick(&board, &point));
+    point.x = 4;
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, minesweeper_board_flag(&board, &point));
+    point.x = 3;
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_WIN, minesweeper_board_pick(&board, &point));
+    for (uint32_t i = 5 * 3; i < MINESWEEPER_PRESET_MAX_SIZE; i++) {
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_STATE_CLEAR_FLAGGED, board_grid[i]);
+    }
+}
+
+void test_board_matches_reference(void) {
+    MINESWEEPER_STATE board_grid[MINESWEEPER_BOARD_SIZE];
+    MINESWEEPER_BOARD board;
+
+    for (uint8_t engine = 0; engine < 2; engine++) {
+        MINESWEEPER_RESULT result = minesweeper_board_init_preset(&board, board_grid, MINESWEEPER_PRESET_BEGINNER);
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+        if (engine == 1) {
+            /* Force the generic engine */
+            board.preset = MINESWEEPER_PRESET_CUSTOM;
+        }
+        result = minesweeper_reset(grid, mines);
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+        result = minesweeper_board_reset(&board, mines);
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+
+        MINESWEEPER_POINT flag = {2, 3};
+        TEST_ASSERT_EQUAL_UINT(minesweeper_flag(grid, &flag), minesweeper_board_flag(&board, &flag));
+        for (uint8_t i = 0; i < (sizeof(winning_points)/sizeof(MINESWEEPER_POINT)); i++) {
+            TEST_ASSERT_EQUAL_UINT(minesweeper_pick(grid, &winning_points[i]),
+                                   minesweeper_board_pick(&board, &winning_points[i]));
+            TEST_ASSERT_EQUAL_MEMORY(grid, board_grid, sizeof(board_grid));
+        }
+    }
+}
+
+void test_random_mines(void) {
+    MINESWEEPER_RANDOM rng;
+    MINESWEEPER_POINT random_mines[99];
+    MINESWEEPER_STATE board_grid[30 * 16];
+    MINESWEEPER_BOARD board;
+    minesweeper_random_seed(&rng, 42, 1);
+
+    MINESWEEPER_RESULT result = minesweeper_board_init_preset(&board, board_grid, MINESWEEPER_PRESET_EXPERT);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    for (uint16_t i = 0; i < 100; i++) {
+        minesweeper_random_mines(&rng, 30, 16, 99, random_mines);
+        /* Reset rejects any duplicate or out of bounds mines */
+        result = minesweeper_board_reset(&board, random_mines);
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    }
+}
+
+/* Plays randomly, counting any view which gives away a hidden mine */
+static bool masked_view_strategy(const MINESWEEPER_SIM_VIEW *view, MINESWEEPER_RANDOM *rng,
+                                 void *context, MINESWEEPER_SIM_MOVE *move) {
+    uint32_t *leaks = context;
+    uint32_t hidden = 0;
+    uint32_t clear = 0;
+    for (uint32_t i = 0; i < (uint32_t)view->width * view->height; i++) {
+        hidden += (MINESWEEPER_SIM_VIEW_HIDDEN == view->points[i]);
+        clear += (MINESWEEPER_SIM_VIEW_CLEAR == view->points[i]);
+    }
+    /* A new game must look the same wherever the mines are */
+    if ((0 == view->shown_points) && (hidden != (uint32_t)view->width * view->height)) {
+        (*leaks)++;
+    }
+    if (clear != view->shown_points) {
+        (*leaks)++;
+    }
+    return minesweeper_sim_strategy_random(view, rng, NULL, move);
+}
+
+void test_sim_run(void) {
+    MINESWEEPER_SIM_STATS stats;
+    MINESWEEPER_SIM_STATS repeat;
+    MINESWEEPER_SIM_CONFIG config = {
+        MINESWEEPER_BOARD_WIDTH, MINESWEEPER_BOARD_HEIGHT, MINESWEEPER_MINE_COUNT,
+        1000, 3, 7, minesweeper_sim_strategy_greedy, NULL, NULL
+    };
+
+    MINESWEEPER_RESULT result = minesweeper_sim_run(&config, &stats);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(1000, stats.games);
+    TEST_ASSERT_EQUAL_UINT(stats.games, stats.wins + stats.losses + stats.resigns + stats.errors);
+    TEST_ASSERT_EQUAL_UINT(0, stats.errors);
+    TEST_ASSERT_TRUE(stats.wins > 0);
+
+    /* Same seed and threads must play the same games */
+    result = minesweeper_sim_run(&config, &repeat);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_MEMORY(&stats, &repeat, sizeof(stats));
+
+    /* Strategies only see what a player would */
+    uint32_t leaks = 0;
+    config.strategy = masked_view_strategy;
+    config.context = &leaks;
+    config.threads = 1;
+    result = minesweeper_sim_run(&config, &stats);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(0, leaks);
+
+    config.strategy = minesweeper_sim_strategy_random;
+    config.mine_count = MINESWEEPER_BOARD_SIZE;
+    result = minesweeper_sim_run(&config, &stats);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, result);
+}
+
+void test_event_log(void) {
+    const char *path = "test_events.bin";
+    MINESWEEPER_STATE board_grid[MINESWEEPER_BOARD_SIZE];
+    MINESWEEPER_BOARD board;
+    uint8_t record[MINESWEEPER_EVENT_RECORD_SIZE];
+    uint8_t ends[2][MINESWEEPER_EVENT_RECORD_SIZE];
+    uint8_t header[4];
+    uint32_t records = 0;
+    uint32_t end_count = 0;
+
+    MINESWEEPER_EVENT_SINK *sink = minesweeper_events_open(path, 32);
+    TEST_ASSERT_NOT_NULL(sink);
+    MINESWEEPER_RESULT result = minesweeper_board_init_preset(&board, board_grid, MINESWEEPER_PRESET_BEGINNER);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    board.events = minesweeper_events_ring(sink);
+    TEST_ASSERT_NOT_NULL(board.events);
+
+    /* 1 start + 11 picks + 1 end, all fit in the ring */
+    result = minesweeper_board_reset(&board, mines);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    for (uint8_t i = 0; i < (sizeof(winning_points)/sizeof(MINESWEEPER_POINT)); i++) {
+        result = minesweeper_board_pick(&board, &winning_points[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_WIN, result);
+
+    /* 1 start + 3 picks + 1 end, losing on the third pick */
+    result = minesweeper_board_reset(&board, mines);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    minesweeper_board_pick(&board, &winning_points[0]);
+    minesweeper_board_pick(&board, &winning_points[1]);
+    uint16_t shown_before_loss = board.shown_points;
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_LOSE, minesweeper_board_pick(&board, &mines[0]));
+    /* Released rings are still flushed before they're freed */
+    minesweeper_events_ring_release(board.events);
+    board.events = NULL;
+    TEST_ASSERT_EQUAL_UINT(0, minesweeper_events_dropped(sink));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, minesweeper_events_close(sink));
+
+    FILE *file = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    while (fread(header, 1, sizeof(header), file) == sizeof(header)) {
+        uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+        TEST_ASSERT_EQUAL_UINT(0, length % MINESWEEPER_EVENT_RECORD_SIZE);
+        for (uint32_t i = 0; i < length; i += MINESWEEPER_EVENT_RECORD_SIZE) {
+            TEST_ASSERT_EQUAL_UINT(sizeof(record), fread(record, 1, sizeof(record), file));
+            records++;
+            if ((MINESWEEPER_EVENT_GAME_END == record[18]) && (end_count < 2)) {
+                memcpy(ends[end_count++], record, sizeof(record));
+            }
+        }
+    }
+    fclose(file);
+    remove(path);
+    TEST_ASSERT_EQUAL_UINT(18, records);
+    TEST_ASSERT_EQUAL_UINT(2, end_count);
+    /* The win revealed every clear point */
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_WIN, ends[0][21]);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_BOARD_SIZE - MINESWEEPER_MINE_COUNT, ends[0][16] | (ends[0][17] << 8));
+    /* The loss logs how far the player got, not the board shown afterwards */
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_LOSE, ends[1][21]);
+    TEST_ASSERT_TRUE(shown_before_loss > 0);
+    TEST_ASSERT_EQUAL_UINT(shown_before_loss, ends[1][16] | (ends[1][17] << 8));
+}
+
+void test_analysis(void) {
+    MINESWEEPER_ANALYSIS analysis;
+    uint8_t adjacent[5 * 5];
+
+    /* A mine in the middle of a 3x3 leaves only numbered points */
+    MINESWEEPER_POINT middle[] = {{1, 1}};
+    MINESWEEPER_RESULT result = minesweeper_analyze(3, 3, 1, middle, adjacent, &analysis);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(0, analysis.openings);
+    TEST_ASSERT_EQUAL_UINT(8, analysis.isolated);
+    TEST_ASSERT_EQUAL_UINT(8, analysis.bbbv);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_ADJACENT_MINE, adjacent[4]);
+    TEST_ASSERT_EQUAL_UINT(1, adjacent[0]);
+
+    /* A wall of mines splits a 5x5 into two openings */
+    MINESWEEPER_POINT wall[] = {{2, 0}, {2, 1}, {2, 2}, {2, 3}, {2, 4}};
+    result = minesweeper_analyze(5, 5, 5, wall, adjacent, &analysis);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(2, analysis.openings);
+    TEST_ASSERT_EQUAL_UINT(0, analysis.isolated);
+    TEST_ASSERT_EQUAL_UINT(2, analysis.bbbv);
+    TEST_ASSERT_EQUAL_UINT(20, analysis.clear_points);
+    TEST_ASSERT_EQUAL_UINT(3, adjacent[(1 * 5) + 2]);
+
+    /* Openings in opposite corners, separated by a band of numbers */
+    MINESWEEPER_POINT corners[] = {{1, 3}, {3, 1}, {4, 4}, {0, 0}};
+    result = minesweeper_analyze(5, 5, 2, corners, NULL, &analysis);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(2, analysis.openings);
+    /* Mines in both corners as well leave no openings at all */
+    result = minesweeper_analyze(5, 5, 4, corners, NULL, &analysis);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT(0, analysis.openings);
+
+    result = minesweeper_analyze(MINESWEEPER_BOARD_WIDTH, MINESWEEPER_BOARD_HEIGHT, MINESWEEPER_MINE_COUNT, mines, NULL, &analysis);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, result);
+    mines[MINESWEEPER_MINE_COUNT-1] = mines[0];
+    result = minesweeper_analyze(MINESWEEPER_BOARD_WIDTH, MINESWEEPER_BOARD_HEIGHT, MINESWEEPER_MINE_COUNT, mines, NULL, &analysis);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, result);
+}
+
+typedef struct {
+    atomic_uint boards;
+    atomic_uint invalid;
+    atomic_uint_fast64_t line_sum;
+    atomic_uint_fast64_t bad_line;
+} ANALYZE_FILES_TOTALS;
+
+static void count_analysis(const char *path, uint64_t line, MINESWEEPER_RESULT result,
+                           const MINESWEEPER_ANALYSIS *analysis, void *context) {
+    ANALYZE_FILES_TOTALS *totals = context;
+    (void)path;
+    (void)analysis;
+    if (MINESWEEPER_RESULT_SUCCESS != result) {
+        atomic_fetch_add(&totals->invalid, 1u);
+        atomic_store(&totals->bad_line, line);
+        return;
+    }
+    atomic_fetch_add(&totals->boards, 1u);
+    atomic_fetch_add(&totals->line_sum, line);
+}
+
+void test_analyze_files(void) {
+    const char *path = "test_boards.txt";
+    const char *paths[] = {path};
+    ANALYZE_FILES_TOTALS totals;
+    uint64_t line_sum = 0;
+    const uint32_t board_count = 4000;
+    const uint32_t bad_line = 2001;
+
+    atomic_init(&totals.boards, 0u);
+    atomic_init(&totals.invalid, 0u);
+    atomic_init(&totals.line_sum, 0u);
+    atomic_init(&totals.bad_line, 0u);
+
+    /* Large enough to be split into several chunks, so one file uses every thread */
+    FILE *file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("# boards\n", file);
+    for (uint32_t line = 2; line <= board_count + 1; line++) {
+        if (bad_line == line) {
+            fputs("8 8 1 9 9\n", file);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS,
+                               minesweeper_analysis_write_board(file, MINESWEEPER_BOARD_WIDTH,
+                                                                MINESWEEPER_BOARD_HEIGHT,
+                                                                MINESWEEPER_MINE_COUNT, mines));
+        line_sum += line;
+    }
+    /* The last line has no newline */
+    fputs("3 3 1 1 1", file);
+    line_sum += board_count + 2;
+    fclose(file);
+
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS,
+                           minesweeper_analyze_files(paths, 1, 4, count_analysis, &totals));
+    TEST_ASSERT_EQUAL_UINT(board_count, atomic_load(&totals.boards));
+    TEST_ASSERT_EQUAL_UINT(1, atomic_load(&totals.invalid));
+    TEST_ASSERT_EQUAL_UINT(bad_line, atomic_load(&totals.bad_line));
+    TEST_ASSERT_TRUE(line_sum == atomic_load(&totals.line_sum));
+    remove(path);
+
+    const char *missing[] = {"test_missing_boards.txt"};
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_UNKNOWN_ERR,
+                           minesweeper_analyze_files(missing, 1, 0, count_analysis, &totals));
+}
+
+/* Waits up to 5 seconds for every queue in the pool to hold at least depth boards */
+static bool wait_for_pool(MINESWEEPER_POOL *pool, uint32_t depth, MINESWEEPER_POOL_STATS *stats) {
+    const struct timespec pause = {0, 1000000L};
+    for (uint32_t i = 0; i < 5000; i++) {
+        minesweeper_pool_stats(pool, stats);
+        if ((stats->depth[MINESWEEPER_PRESET_BEGINNER] >= depth) &&
+            (stats->depth[MINESWEEPER_PRESET_INTERMEDIATE] >= depth) &&
+            (stats->depth[MINESWEEPER_PRESET_EXPERT] >= depth)) {
+            return true;
+        }
+        nanosleep(&pause, NULL);
+    }
+    return false;
+}
+
+void test_pool(void) {
+    MINESWEEPER_POOL_CONFIG config = {4, 1, 7, {10, 0, 0}, {40, 0, 0}};
+    MINESWEEPER_POOL_STATS stats;
+    MINESWEEPER_POOL_BOARD ready;
+    MINESWEEPER_ANALYSIS analysis;
+    MINESWEEPER_STATE board_grid[MINESWEEPER_PRESET_MAX_SIZE];
+    MINESWEEPER_BOARD board;
+
+    MINESWEEPER_POOL *pool = minesweeper_pool_create(&config);
+    TEST_ASSERT_NOT_NULL(pool);
+    /* Wait for the refill thread to fill every queue */
+    TEST_ASSERT_TRUE(wait_for_pool(pool, 4, &stats));
+
+    /* Each board matches a fresh analysis and is within the 3BV limits */
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(minesweeper_pool_pop(pool, MINESWEEPER_PRESET_BEGINNER, &ready));
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_BEGINNER, ready.preset);
+        TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS,
+            minesweeper_analyze(8, 8, 10, ready.mines, NULL, &analysis));
+        TEST_ASSERT_EQUAL_UINT(analysis.bbbv, ready.analysis.bbbv);
+        TEST_ASSERT_TRUE((ready.analysis.bbbv >= 10) && (ready.analysis.bbbv <= 40));
+    }
+
+    /* A new game plays the board that was taken */
+    minesweeper_board_init_preset(&board, board_grid, MINESWEEPER_PRESET_EXPERT);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_SUCCESS, minesweeper_pool_new_game(pool, &board, &ready));
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_PRESET_EXPERT, ready.preset);
+    MINESWEEPER_POINT mine = ready.mines[0];
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_LOSE, minesweeper_board_pick(&board, &mine));
+
+    /* Custom sizes aren't pooled */
+    minesweeper_board_init(&board, board_grid, 5, 5, 3);
+    TEST_ASSERT_EQUAL_UINT(MINESWEEPER_RESULT_OUT_OF_BOUNDS, minesweeper_pool_new_game(pool, &board, NULL));
+    TEST_ASSERT_FALSE(minesweeper_pool_pop(pool, MINESWEEPER_PRESET_CUSTOM, &ready));
+
+    /*
+     * Emptying the beginner queue wakes the refill thread to top it back up.
+     * Expert only lost one board, which leaves it above the low water mark,
+     * so it may not be refilled.
+     */
+    TEST_ASSERT_TRUE(wait_for_pool(pool, 3, &stats));
+    TEST_ASSERT_EQUAL_UINT(4, stats.popped[MINESWEEPER_PRESET_BEGINNER]);
+    TEST_ASSERT_EQUAL_UINT(1, stats.popped[MINESWEEPER_PRESET_EXPERT]);
+    TEST_ASSERT_TRUE(stats.generated[MINESWEEPER_PRESET_BEGINNER] >= 8);
+    TEST_ASSERT_TRUE(stats.refill_rate[MINESWEEPER_PRESET_BEGINNER] > 0.0);
+    minesweeper_pool_destroy(pool);
+
+    /* A 3BV range no board can be in is refused */
+    config.min_bbbv[MINESWEEPER_PRESET_BEGINNER] = 41;
+    TEST_ASSERT_TRUE(NULL == minesweeper_pool_create(&config));
+}
+
 
 int main(void) {
     UNITY_BEGIN();
@@ -298,5 +732,15 @@ int main(void) {
     RUN_TEST(test_flag_mine);
     RUN_TEST(test_flag_clear);
     RUN_TEST(test_win_game);
+    RUN_TEST(test_board_preset_dispatch);
+    RUN_TEST(test_board_custom_size);
+    RUN_TEST(test_board_preset_mismatch);
+    RUN_TEST(test_board_matches_reference);
+    RUN_TEST(test_random_mines);
+    RUN_TEST(test_sim_run);
+    RUN_TEST(test_event_log);
+    RUN_TEST(test_analysis);
+    RUN_TEST(test_analyze_files);
+    RUN_TEST(test_pool);
     return UNITY_END();
 }
\ No newline at end of file